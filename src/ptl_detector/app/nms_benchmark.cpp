@@ -0,0 +1,118 @@
+// run nms on synthetic dense crowd proposals, with nmsAllClasses and the NmsEngine
+// usage: nms_benchmark [person_num] [proposals_per_person] [iteration_num] [top_k]
+// each person gets proposals_per_person jittered boxes around its true box, most of them labeled person,
+// the persons stand in rows like a crowd, so their boxes overlap with the neighbours
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <string>
+
+#include "nms_engine.h"
+#include "trt_utils.h"
+
+std::vector<BBoxInfo> generate_crowd(const int person_num, const int proposals_per_person, std::mt19937 &rng)
+{
+    const float image_w = 1920, image_h = 1080;
+    std::uniform_real_distribution<float> uniform(0, 1);
+    std::normal_distribution<float> jitter(0, 0.08);
+    std::vector<BBoxInfo> binfo;
+    for (int p = 0; p < person_num; p++)
+    {
+        const float h = 120 + 300 * uniform(rng);
+        const float w = h * (0.35 + 0.15 * uniform(rng));
+        const float cx = image_w * uniform(rng);
+        const float cy = image_h * (0.3 + 0.5 * uniform(rng));
+        for (int k = 0; k < proposals_per_person; k++)
+        {
+            BBoxInfo b;
+            const float bx = cx + w * jitter(rng), by = cy + h * jitter(rng);
+            const float bw = w * std::exp(jitter(rng)), bh = h * std::exp(jitter(rng));
+            b.box.x1 = clamp(bx - bw / 2, 0, image_w);
+            b.box.x2 = clamp(bx + bw / 2, 0, image_w);
+            b.box.y1 = clamp(by - bh / 2, 0, image_h);
+            b.box.y2 = clamp(by + bh / 2, 0, image_h);
+            b.label = uniform(rng) < 0.9 ? 0 : 1 + int(79 * uniform(rng));
+            b.classId = b.label;
+            b.prob = 0.5 + 0.5 * uniform(rng);
+            binfo.push_back(b);
+        }
+    }
+    std::shuffle(binfo.begin(), binfo.end(), rng);
+    return binfo;
+}
+
+bool same_result(const std::vector<BBoxInfo> &a, const std::vector<BBoxInfo> &b)
+{
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (a[i].box.x1 != b[i].box.x1 || a[i].box.y1 != b[i].box.y1 || a[i].box.x2 != b[i].box.x2 ||
+            a[i].box.y2 != b[i].box.y2 || a[i].label != b[i].label || a[i].prob != b[i].prob)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Func>
+double time_us(const int iteration_num, Func func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iteration_num; i++)
+    {
+        func();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iteration_num;
+}
+
+int main(int argc, char *argv[])
+{
+    const int person_num = argc > 1 ? std::stoi(argv[1]) : 100;
+    const int proposals_per_person = argc > 2 ? std::stoi(argv[2]) : 10;
+    const int iteration_num = argc > 3 ? std::stoi(argv[3]) : 200;
+    const int top_k = argc > 4 ? std::stoi(argv[4]) : 0;
+    const float nms_thresh = 0.5;
+    const uint32_t num_classes = 80;
+
+    std::mt19937 rng(0);
+    std::vector<BBoxInfo> binfo = generate_crowd(person_num, proposals_per_person, rng);
+    std::cout << "proposals: " << binfo.size() << std::endl;
+
+    NmsEngine engine;
+    std::vector<BBoxInfo> result_engine, result_reference;
+    for (auto type : {NmsType::kIoU, NmsType::kDIoU})
+    {
+        const std::string model_type = type == NmsType::kIoU ? "yolov3" : "yolov4-tiny";
+        const std::string name = type == NmsType::kIoU ? "IoU" : "DIoU";
+        engine.setTopK(0);
+        result_reference = nmsAllClasses(nms_thresh, binfo, num_classes, model_type);
+        engine.run(binfo, nms_thresh, type, result_engine);
+        const bool is_same = same_result(result_reference, result_engine);
+        std::cout << name << " nms: kept " << result_reference.size() << ", "
+                  << (is_same ? "the engine agrees with nmsAllClasses" : "MISMATCH between the engine and nmsAllClasses") << std::endl;
+        if (!is_same)
+        {
+            return 1;
+        }
+
+        const double t_reference = time_us(iteration_num, [&]() { result_reference = nmsAllClasses(nms_thresh, binfo, num_classes, model_type); });
+        const double t_engine = time_us(iteration_num, [&]() { engine.run(binfo, nms_thresh, type, result_engine); });
+        std::cout << "  nmsAllClasses: " << t_reference << " us" << std::endl;
+        std::cout << "  NmsEngine: " << t_engine << " us (x" << t_reference / t_engine << ")" << std::endl;
+        if (top_k > 0)
+        {
+            engine.setTopK(top_k);
+            const double t_top_k = time_us(iteration_num, [&]() { engine.run(binfo, nms_thresh, type, result_engine); });
+            std::cout << "  NmsEngine top " << top_k << ": " << t_top_k << " us (x" << t_reference / t_top_k << "), kept "
+                      << result_engine.size() << std::endl;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+// decode synthetic yolov4-tiny outputs on the CPU, with the scalar decoder and the vectorized YoloDecoder
+// usage: yolo_decode_benchmark [iteration_num] [positive_ratio] [num_classes] [input_size]
+// positive_ratio is the ratio of the cells with a high objectness, the other cells have an objectness below 0.1
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iterator>
+#include <random>
+#include <string>
+#include <tuple>
+
+#include "yolo.h"
+#include "yolo_decoder.h"
+
+// the decoder of YoloV3/V4/V5 before vectorization, kept as the reference
+void decode_scalar(const float *detections, const TensorInfo &tensor, const float prob_thresh, const uint32_t net_w,
+                   const uint32_t net_h, const uint32_t image_w, const uint32_t image_h, std::vector<BBoxInfo> &binfo)
+{
+    const int num_grid_cells = tensor.grid_h * tensor.grid_w;
+    for (uint32_t y = 0; y < tensor.grid_h; ++y)
+    {
+        for (uint32_t x = 0; x < tensor.grid_w; ++x)
+        {
+            for (uint32_t b = 0; b < tensor.numBBoxes; ++b)
+            {
+                const float pw = tensor.anchors[tensor.masks[b] * 2];
+                const float ph = tensor.anchors[tensor.masks[b] * 2 + 1];
+                const int bbindex = y * tensor.grid_w + x;
+                const float *plane = detections + num_grid_cells * b * (5 + tensor.numClasses);
+                const float bx = x + plane[bbindex];
+                const float by = y + plane[bbindex + num_grid_cells];
+                const float bw = pw * plane[bbindex + num_grid_cells * 2];
+                const float bh = ph * plane[bbindex + num_grid_cells * 3];
+                const float objectness = plane[bbindex + num_grid_cells * 4];
+
+                float max_prob = 0.0f;
+                int max_index = -1;
+                for (uint32_t i = 0; i < tensor.numClasses; ++i)
+                {
+                    float prob = plane[bbindex + num_grid_cells * (5 + i)];
+                    if (prob > max_prob)
+                    {
+                        max_prob = prob;
+                        max_index = i;
+                    }
+                }
+                max_prob = objectness * max_prob;
+                if (max_prob > prob_thresh)
+                {
+                    BBoxInfo bbi;
+                    const float cx = bx * tensor.stride_w;
+                    const float cy = by * tensor.stride_h;
+                    bbi.box.x1 = clamp(cx - bw / 2, 0, net_w);
+                    bbi.box.x2 = clamp(cx + bw / 2, 0, net_w);
+                    bbi.box.y1 = clamp(cy - bh / 2, 0, net_h);
+                    bbi.box.y2 = clamp(cy + bh / 2, 0, net_h);
+                    if ((bbi.box.x1 > bbi.box.x2) || (bbi.box.y1 > bbi.box.y2))
+                    {
+                        continue;
+                    }
+                    convertBBoxImgRes(0, net_w, net_h, image_w, image_h, bbi.box);
+                    bbi.label = max_index;
+                    bbi.prob = max_prob;
+                    bbi.classId = max_index;
+                    binfo.push_back(bbi);
+                }
+            }
+        }
+    }
+}
+
+// the proposals are compared after sorting, since the decoders visit the cells in a different order
+bool same_proposals(std::vector<BBoxInfo> a, std::vector<BBoxInfo> b)
+{
+    auto less = [](const BBoxInfo &l, const BBoxInfo &r) {
+        return std::tie(l.box.x1, l.box.y1, l.box.x2, l.box.y2, l.label) < std::tie(r.box.x1, r.box.y1, r.box.x2, r.box.y2, r.label);
+    };
+    if (a.size() != b.size())
+    {
+        return false;
+    }
+    std::sort(a.begin(), a.end(), less);
+    std::sort(b.begin(), b.end(), less);
+    for (size_t i = 0; i < a.size(); i++)
+    {
+        if (std::abs(a[i].box.x1 - b[i].box.x1) > 1e-3 || std::abs(a[i].box.y1 - b[i].box.y1) > 1e-3 ||
+            std::abs(a[i].box.x2 - b[i].box.x2) > 1e-3 || std::abs(a[i].box.y2 - b[i].box.y2) > 1e-3 ||
+            a[i].label != b[i].label || std::abs(a[i].prob - b[i].prob) > 1e-6)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <typename Func>
+double time_us(const int iteration_num, Func func)
+{
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iteration_num; i++)
+    {
+        func();
+    }
+    auto end = std::chrono::steady_clock::now();
+    return std::chrono::duration<double, std::micro>(end - start).count() / iteration_num;
+}
+
+int main(int argc, char *argv[])
+{
+    const int iteration_num = argc > 1 ? std::stoi(argv[1]) : 1000;
+    const float positive_ratio = argc > 2 ? std::stof(argv[2]) : 0.002;
+    const uint32_t num_classes = argc > 3 ? std::stoi(argv[3]) : 80;
+    const uint32_t input_size = argc > 4 ? std::stoi(argv[4]) : 416;
+    const float prob_thresh = 0.5;
+    const uint32_t image_w = 1920, image_h = 1080;
+
+    //the two output layers of yolov4-tiny
+    const std::vector<float> anchors = {10, 14, 23, 27, 37, 58, 81, 82, 135, 169, 344, 319};
+    std::vector<TensorInfo> tensors(2);
+    tensors[0].stride_h = tensors[0].stride_w = 32;
+    tensors[0].masks = {3, 4, 5};
+    tensors[1].stride_h = tensors[1].stride_w = 16;
+    tensors[1].masks = {1, 2, 3};
+    std::mt19937 rng(0);
+    std::uniform_real_distribution<float> uniform(0, 1);
+    std::normal_distribution<float> normal(0, 0.5);
+    std::vector<std::vector<float>> buffers;
+    for (auto &t : tensors)
+    {
+        t.grid_h = input_size / t.stride_h;
+        t.grid_w = input_size / t.stride_w;
+        t.numClasses = num_classes;
+        t.numBBoxes = t.masks.size();
+        t.anchors = anchors;
+        const uint32_t cells = t.grid_h * t.grid_w;
+        t.volume = cells * t.numBBoxes * (5 + num_classes);
+        std::vector<float> buffer(t.volume);
+        for (uint32_t b = 0; b < t.numBBoxes; b++)
+        {
+            float *plane = buffer.data() + cells * b * (5 + num_classes);
+            for (uint32_t i = 0; i < cells; i++)
+            {
+                plane[i] = uniform(rng);
+                plane[cells + i] = uniform(rng);
+                plane[cells * 2 + i] = std::exp(normal(rng));
+                plane[cells * 3 + i] = std::exp(normal(rng));
+                plane[cells * 4 + i] = uniform(rng) < positive_ratio ? 0.5 + 0.5 * uniform(rng) : 0.1 * uniform(rng);
+            }
+            for (uint32_t i = cells * 5; i < cells * (5 + num_classes); i++)
+            {
+                plane[i] = uniform(rng);
+            }
+        }
+        buffers.push_back(std::move(buffer));
+    }
+    for (size_t i = 0; i < tensors.size(); i++)
+    {
+        tensors[i].hostBuffer = buffers[i].data();
+    }
+    std::cout << "cells x anchors: " << YoloDecoder::maxProposals(tensors) << ", classes: " << num_classes
+              << ", positive ratio: " << positive_ratio << std::endl;
+
+    //check the vectorized decoder against the reference
+    std::vector<BBoxInfo> binfo_scalar, binfo_vector, binfo_whitelist;
+    YoloDecoder decoder;
+    decoder.setProbThresh(prob_thresh);
+    YoloDecoder decoder_whitelist;
+    decoder_whitelist.setProbThresh(prob_thresh);
+    decoder_whitelist.setClassWhitelist({0});
+    auto run_scalar = [&]() {
+        binfo_scalar.clear();
+        for (auto &t : tensors)
+        {
+            decode_scalar(t.hostBuffer, t, prob_thresh, input_size, input_size, image_w, image_h, binfo_scalar);
+        }
+    };
+    auto run_vector = [&](YoloDecoder &d, std::vector<BBoxInfo> &binfo) {
+        binfo.clear();
+        binfo.reserve(YoloDecoder::maxProposals(tensors));
+        for (auto &t : tensors)
+        {
+            d.decode(t.hostBuffer, t, input_size, input_size, image_w, image_h, binfo);
+        }
+    };
+    run_scalar();
+    run_vector(decoder, binfo_vector);
+    run_vector(decoder_whitelist, binfo_whitelist);
+    std::vector<BBoxInfo> binfo_class0;
+    std::copy_if(binfo_scalar.begin(), binfo_scalar.end(), std::back_inserter(binfo_class0),
+                 [](const BBoxInfo &b) { return b.label == 0; });
+    const bool is_same = same_proposals(binfo_scalar, binfo_vector) && same_proposals(binfo_class0, binfo_whitelist);
+    std::cout << "proposals: " << binfo_scalar.size() << " (class 0: " << binfo_class0.size() << "), "
+              << (is_same ? "the decoders agree" : "MISMATCH between the decoders") << std::endl;
+
+    const double t_scalar = time_us(iteration_num, run_scalar);
+    const double t_vector = time_us(iteration_num, [&]() { run_vector(decoder, binfo_vector); });
+    const double t_whitelist = time_us(iteration_num, [&]() { run_vector(decoder_whitelist, binfo_whitelist); });
+    std::cout << "scalar decode: " << t_scalar << " us/image" << std::endl;
+    std::cout << "vectorized decode: " << t_vector << " us/image (x" << t_scalar / t_vector << ")" << std::endl;
+    std::cout << "vectorized decode, class 0 only: " << t_whitelist << " us/image (x" << t_scalar / t_whitelist << ")" << std::endl;
+    return is_same ? 0 : 1;
+}
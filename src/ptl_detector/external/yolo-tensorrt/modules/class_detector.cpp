@@ -20,11 +20,13 @@ Detector::~Detector() {
   }
 }
 
-void Detector::init(const Config &config) { _impl->_detector.init(config); }
+bool Detector::init(const Config &config) {
+  return _impl->_detector.init(config);
+}
 
-void Detector::detect(const std::vector<cv::Mat> &mat_image,
+bool Detector::detect(const std::vector<cv::Mat> &mat_image,
                       std::vector<BatchResult> &vec_batch_result) {
-  _impl->_detector.detect(mat_image, vec_batch_result);
+  return _impl->_detector.detect(mat_image, vec_batch_result);
 }
 
 void Detector::setProbThresh(float m_prob_thresh) {
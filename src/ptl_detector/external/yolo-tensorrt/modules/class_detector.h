@@ -48,6 +48,12 @@ struct Config {
   float max_width = 500;
   float max_height = 50;
   float min_height = 500;
+
+  // only detect these classes (e.g. {0} for person in coco), empty for all
+  std::vector<int> class_whitelist;
+
+  // only the nms_top_k proposals of the highest score go into nms, 0 for all
+  int nms_top_k = 0;
 };
 
 class API Detector {
@@ -56,9 +62,11 @@ class API Detector {
 
   ~Detector();
 
-  void init(const Config &config);
+  // return false if the detector can not be initialized
+  bool init(const Config &config);
 
-  void detect(const std::vector<cv::Mat> &mat_image,
+  // return false if an image is not 8-bit bgr
+  bool detect(const std::vector<cv::Mat> &mat_image,
               std::vector<BatchResult> &vec_batch_result);
 
   void setProbThresh(float m_prob_thresh);
@@ -12,6 +12,8 @@
 #include "class_detector.h"
 #include "class_timer.hpp"
 #include "ds_image.h"
+#include "nms_engine.h"
+#include "preprocess_workspace.h"
 #include "trt_utils.h"
 #include "yolo.h"
 #include "yolov2.h"
@@ -24,40 +26,65 @@ public:
     YoloDetector() {}
     ~YoloDetector() {}
 
-    void init(const Config &config)
+    bool init(const Config &config)
     {
         _config = config;
         this->set_gpu_id(_config.gpu_id);
         this->parse_config();
         this->build_net();
+        return _workspace.init(std::max(1, _config.n_max_batch), _p_net->getInputH(), _p_net->getInputW());
     }
 
-    void detect(const std::vector<cv::Mat> &vec_image,
+    // the images over the max batch of the engine are detected in several inferences
+    bool detect(const std::vector<cv::Mat> &vec_image,
                 std::vector<BatchResult> &vec_batch_result)
     {
-        std::vector<DsImage> vec_ds_images;
-        vec_batch_result.clear();
+        // keep the capacity of the results of the caller
         vec_batch_result.resize(vec_image.size());
-        for (const auto &img : vec_image)
+        for (auto &batch_result : vec_batch_result)
         {
-            vec_ds_images.emplace_back(img, _p_net->getInputH(), _p_net->getInputW());
+            batch_result.clear();
         }
-        cv::Mat trtInput = blobFromDsImages(vec_ds_images, _p_net->getInputH(),
-                                            _p_net->getInputW());
-        _p_net->doInference(trtInput.data, vec_ds_images.size());
-        for (uint32_t i = 0; i < vec_ds_images.size(); ++i)
+        const size_t max_batch = _workspace.capacity();
+        if (0 == max_batch)
         {
-            auto curImage = vec_ds_images.at(i);
-            auto binfo = _p_net->decodeDetections(i, curImage.getImageHeight(),
-                                                  curImage.getImageWidth());
-            auto remaining =
-                nmsAllClasses(_p_net->getNMSThresh(), binfo, _p_net->getNumClasses(),
-                              _vec_net_type[_config.net_type]);
+            return false;
+        }
+        for (size_t first = 0; first < vec_image.size(); first += max_batch)
+        {
+            const uint32_t count = std::min(max_batch, vec_image.size() - first);
+            const float *trtInput = _workspace.process(vec_image, first, count);
+            if (!trtInput)
+            {
+                return false;
+            }
+            _p_net->doInference(reinterpret_cast<const unsigned char *>(trtInput), count);
+            decode(vec_image, first, count, vec_batch_result);
+        }
+        return true;
+    }
+
+    void setProbThresh(float m_prob_thresh)
+    {
+        _p_net->setProbThresh(m_prob_thresh);
+    };
+
+private:
+    void decode(const std::vector<cv::Mat> &vec_image, const size_t first, const uint32_t count,
+                std::vector<BatchResult> &vec_batch_result)
+    {
+        for (uint32_t i = 0; i < count; ++i)
+        {
+            const cv::Mat &image = vec_image[first + i];
+            _p_net->decodeDetections(i, image.rows, image.cols, _proposals);
+            _nms.run(_proposals, _p_net->getNMSThresh(), _nms_type, _detections);
+            const auto &remaining = _detections;
             if (0 == remaining.size())
             {
                 continue;
             }
-            std::vector<Result> vec_result(0);
+            auto &vec_result = vec_batch_result[first + i];
+            vec_result.reserve(remaining.size());
             for (const auto &b : remaining)
             {
                 Result res;
@@ -70,16 +97,9 @@ public:
                 res.rect = cv::Rect(x, y, w, h);
                 vec_result.push_back(res);
             }
-            vec_batch_result[i] = vec_result;
         }
     }
 
-    void setProbThresh(float m_prob_thresh)
-    {
-        _p_net->setProbThresh(m_prob_thresh);
-    };
-
-private:
     void set_gpu_id(const int id = 0)
     {
         cudaError_t status = cudaSetDevice(id);
@@ -139,6 +159,11 @@ private:
         {
             assert(false && "Unrecognised network_type.");
         }
+        const std::string &net_type = _vec_net_type[_config.net_type];
+        _nms_type = (net_type == "yolov5" || net_type == "yolov4" || net_type == "yolov4-tiny") ? NmsType::kDIoU : NmsType::kIoU;
+        _nms.setTopK(std::max(0, _config.nms_top_k));
+        _p_net->setClassWhitelist(std::vector<uint32_t>(_config.class_whitelist.begin(),
+                                                        _config.class_whitelist.end()));
     }
 
 private:
@@ -150,6 +175,11 @@ private:
                                            "yolov5"};
     std::vector<std::string> _vec_precision{"kINT8", "kHALF", "kFLOAT"};
     std::unique_ptr<Yolo> _p_net = nullptr;
+    std::vector<BBoxInfo> _proposals; // decoded detections of an image, reused between images
+    std::vector<BBoxInfo> _detections; // detections after nms
+    NmsEngine _nms;
+    NmsType _nms_type = NmsType::kIoU;
+    PreprocessWorkspace _workspace; // input buffer of the network, reused between frames
     Timer _m_timer;
 };
 
@@ -0,0 +1,193 @@
+#include "nms_engine.h"
+
+#include <algorithm>
+#include <numeric>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define NMS_ENGINE_SIMD
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#define NMS_ENGINE_SIMD
+#endif
+
+namespace {
+
+// overlap score of a candidate against a kept box, same arithmetic as
+// nonMaximumSuppression (IoU) and diou_nms (IoU - R)
+inline float overlapScore(const float x1, const float y1, const float x2,
+                          const float y2, const float area, const float kx1,
+                          const float ky1, const float kx2, const float ky2,
+                          const float karea, const NmsType type) {
+  const float w = std::max(0.0f, std::min(x2, kx2) - std::max(x1, kx1));
+  const float h = std::max(0.0f, std::min(y2, ky2) - std::max(y1, ky1));
+  const float overlap = w * h;
+  const float u = area + karea - overlap;
+  const float iou = u == 0 ? 0 : overlap / u;
+  if (type == NmsType::kIoU) return iou;
+
+  const float dx = (x1 + x2) / 2.f - (kx1 + kx2) / 2.f;
+  const float dy = (y1 + y2) / 2.f - (ky1 + ky2) / 2.f;
+  const float ex = std::min(x1, kx1) - std::max(x2, kx2);
+  const float ey = std::min(y1, ky1) - std::max(y2, ky2);
+  return iou - (dx * dx + dy * dy) / (ex * ex + ey * ey);
+}
+
+#if defined(__SSE2__)
+typedef __m128 vfloat;
+inline vfloat vload(const float* p) { return _mm_loadu_ps(p); }
+inline vfloat vset(const float v) { return _mm_set1_ps(v); }
+inline vfloat vadd(vfloat a, vfloat b) { return _mm_add_ps(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return _mm_sub_ps(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return _mm_mul_ps(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return _mm_div_ps(a, b); }
+inline vfloat vmin(vfloat a, vfloat b) { return _mm_min_ps(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return _mm_max_ps(a, b); }
+// a where b != 0, else 0
+inline vfloat vzeroWhere(vfloat a, vfloat b) {
+  return _mm_and_ps(a, _mm_cmpneq_ps(b, _mm_setzero_ps()));
+}
+// whether any lane is not <= t (NaN included)
+inline bool vanyAbove(vfloat a, vfloat t) {
+  return _mm_movemask_ps(_mm_cmpnle_ps(a, t)) != 0;
+}
+#elif defined(NMS_ENGINE_SIMD)
+typedef float32x4_t vfloat;
+inline vfloat vload(const float* p) { return vld1q_f32(p); }
+inline vfloat vset(const float v) { return vdupq_n_f32(v); }
+inline vfloat vadd(vfloat a, vfloat b) { return vaddq_f32(a, b); }
+inline vfloat vsub(vfloat a, vfloat b) { return vsubq_f32(a, b); }
+inline vfloat vmul(vfloat a, vfloat b) { return vmulq_f32(a, b); }
+inline vfloat vdiv(vfloat a, vfloat b) { return vdivq_f32(a, b); }
+inline vfloat vmin(vfloat a, vfloat b) { return vminq_f32(a, b); }
+inline vfloat vmax(vfloat a, vfloat b) { return vmaxq_f32(a, b); }
+inline vfloat vzeroWhere(vfloat a, vfloat b) {
+  return vreinterpretq_f32_u32(vbicq_u32(vreinterpretq_u32_f32(a),
+                                         vceqq_f32(b, vdupq_n_f32(0))));
+}
+inline bool vanyAbove(vfloat a, vfloat t) {
+  return vminvq_u32(vcleq_f32(a, t)) == 0;
+}
+#endif
+
+}  // namespace
+
+void NmsEngine::run(const std::vector<BBoxInfo>& binfo, const float nmsThresh,
+                    const NmsType type, std::vector<BBoxInfo>& result) {
+  result.clear();
+  m_Order.resize(binfo.size());
+  std::iota(m_Order.begin(), m_Order.end(), 0);
+
+  // higher score first, ties in input order as the stable sort of nms
+  auto higher = [&binfo](const uint32_t a, const uint32_t b) {
+    return binfo[a].prob > binfo[b].prob ||
+           (binfo[a].prob == binfo[b].prob && a < b);
+  };
+  if (m_TopK > 0 && m_Order.size() > m_TopK) {
+    std::nth_element(m_Order.begin(), m_Order.begin() + m_TopK, m_Order.end(),
+                     higher);
+    m_Order.resize(m_TopK);
+  }
+  std::sort(m_Order.begin(), m_Order.end(),
+            [&binfo, &higher](const uint32_t a, const uint32_t b) {
+              return binfo[a].label != binfo[b].label
+                         ? binfo[a].label < binfo[b].label
+                         : higher(a, b);
+            });
+
+  const uint32_t n = m_Order.size();
+  m_X1.resize(n);
+  m_Y1.resize(n);
+  m_X2.resize(n);
+  m_Y2.resize(n);
+  m_Area.resize(n);
+  for (uint32_t i = 0; i < n; ++i) {
+    const BBox& b = binfo[m_Order[i]].box;
+    m_X1[i] = b.x1;
+    m_Y1[i] = b.y1;
+    m_X2[i] = b.x2;
+    m_Y2[i] = b.y2;
+    m_Area[i] = (b.x2 - b.x1) * (b.y2 - b.y1);
+  }
+
+  // a kept box not overlapping the candidate has IoU 0 (and -R for DIoU),
+  // which cannot pass a threshold >= 0, so only the x-overlapping ones count
+  const bool sweep = nmsThresh >= 0;
+  for (uint32_t classBegin = 0; classBegin < n;) {
+    const int label = binfo[m_Order[classBegin]].label;
+    uint32_t classEnd = classBegin;
+    while (classEnd < n && binfo[m_Order[classEnd]].label == label) ++classEnd;
+
+    m_KeptX1.clear();
+    m_KeptY1.clear();
+    m_KeptX2.clear();
+    m_KeptY2.clear();
+    m_KeptArea.clear();
+    float maxKeptWidth = 0;
+    for (uint32_t i = classBegin; i < classEnd; ++i) {
+      uint32_t begin = 0, end = m_KeptX1.size();
+      if (sweep) {
+        // 1 pixel of margin against rounding, the extra boxes are exact anyway
+        begin = std::lower_bound(m_KeptX1.begin(), m_KeptX1.end(),
+                                 m_X1[i] - maxKeptWidth - 1) -
+                m_KeptX1.begin();
+        end = std::upper_bound(m_KeptX1.begin(), m_KeptX1.end(), m_X2[i] + 1) -
+              m_KeptX1.begin();
+      }
+      if (isSuppressed(i, begin, end, nmsThresh, type)) continue;
+      keep(i);
+      maxKeptWidth = std::max(maxKeptWidth, m_X2[i] - m_X1[i]);
+      result.push_back(binfo[m_Order[i]]);
+    }
+    classBegin = classEnd;
+  }
+}
+
+bool NmsEngine::isSuppressed(const uint32_t i, const uint32_t begin,
+                             const uint32_t end, const float nmsThresh,
+                             const NmsType type) const {
+  uint32_t j = begin;
+#if defined(NMS_ENGINE_SIMD)
+  const vfloat x1 = vset(m_X1[i]), y1 = vset(m_Y1[i]);
+  const vfloat x2 = vset(m_X2[i]), y2 = vset(m_Y2[i]);
+  const vfloat area = vset(m_Area[i]);
+  const vfloat zero = vset(0), half = vset(0.5f), thresh = vset(nmsThresh);
+  const vfloat cx = vmul(vadd(x1, x2), half), cy = vmul(vadd(y1, y2), half);
+  for (; j + 4 <= end; j += 4) {
+    const vfloat kx1 = vload(&m_KeptX1[j]), ky1 = vload(&m_KeptY1[j]);
+    const vfloat kx2 = vload(&m_KeptX2[j]), ky2 = vload(&m_KeptY2[j]);
+    const vfloat w = vmax(zero, vsub(vmin(x2, kx2), vmax(x1, kx1)));
+    const vfloat h = vmax(zero, vsub(vmin(y2, ky2), vmax(y1, ky1)));
+    const vfloat overlap = vmul(w, h);
+    const vfloat u = vsub(vadd(area, vload(&m_KeptArea[j])), overlap);
+    vfloat score = vzeroWhere(vdiv(overlap, u), u);
+    if (type == NmsType::kDIoU) {
+      const vfloat dx = vsub(cx, vmul(vadd(kx1, kx2), half));
+      const vfloat dy = vsub(cy, vmul(vadd(ky1, ky2), half));
+      const vfloat ex = vsub(vmin(x1, kx1), vmax(x2, kx2));
+      const vfloat ey = vsub(vmin(y1, ky1), vmax(y2, ky2));
+      score = vsub(score, vdiv(vadd(vmul(dx, dx), vmul(dy, dy)),
+                               vadd(vmul(ex, ex), vmul(ey, ey))));
+    }
+    if (vanyAbove(score, thresh)) return true;
+  }
+#endif
+  for (; j < end; ++j) {
+    const float score = overlapScore(
+        m_X1[i], m_Y1[i], m_X2[i], m_Y2[i], m_Area[i], m_KeptX1[j],
+        m_KeptY1[j], m_KeptX2[j], m_KeptY2[j], m_KeptArea[j], type);
+    if (!(score <= nmsThresh)) return true;
+  }
+  return false;
+}
+
+void NmsEngine::keep(const uint32_t i) {
+  const uint32_t pos =
+      std::upper_bound(m_KeptX1.begin(), m_KeptX1.end(), m_X1[i]) -
+      m_KeptX1.begin();
+  m_KeptX1.insert(m_KeptX1.begin() + pos, m_X1[i]);
+  m_KeptY1.insert(m_KeptY1.begin() + pos, m_Y1[i]);
+  m_KeptX2.insert(m_KeptX2.begin() + pos, m_X2[i]);
+  m_KeptY2.insert(m_KeptY2.begin() + pos, m_Y2[i]);
+  m_KeptArea.insert(m_KeptArea.begin() + pos, m_Area[i]);
+}
@@ -0,0 +1,44 @@
+#ifndef _NMS_ENGINE_H_
+#define _NMS_ENGINE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "yolo_types.h"
+
+enum class NmsType { kIoU, kDIoU };
+
+/**
+ * Greedy per-class non maximum suppression on one proposal buffer, giving the
+ * same result as nmsAllClasses.
+ *
+ * The proposals are sorted once by class and then score, and copied into
+ * structure-of-arrays buffers, so each class is a contiguous range. The kept
+ * boxes of a class are sorted by x1, so a candidate is only compared (4 boxes
+ * at a time with SSE/NEON) against the kept boxes overlapping it horizontally;
+ * the others have no overlap and cannot suppress it when nmsThresh >= 0.
+ * All the buffers are reused between calls.
+ */
+class NmsEngine {
+ public:
+  // only the topK proposals of the highest score go into nms, 0 for all
+  void setTopK(const uint32_t topK) { m_TopK = topK; }
+
+  void run(const std::vector<BBoxInfo>& binfo, const float nmsThresh,
+           const NmsType type, std::vector<BBoxInfo>& result);
+
+ private:
+  bool isSuppressed(const uint32_t i, const uint32_t begin, const uint32_t end,
+                    const float nmsThresh, const NmsType type) const;
+  void keep(const uint32_t i);
+
+  uint32_t m_TopK = 0;
+  std::vector<uint32_t> m_Order;
+  // proposals sorted by class and score
+  std::vector<float> m_X1, m_Y1, m_X2, m_Y2, m_Area;
+  // kept boxes of the current class, sorted by x1
+  std::vector<float> m_KeptX1, m_KeptY1, m_KeptX2, m_KeptY2, m_KeptArea;
+};
+
+#endif  // _NMS_ENGINE_H_
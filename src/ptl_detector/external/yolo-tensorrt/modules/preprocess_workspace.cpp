@@ -0,0 +1,83 @@
+#include "preprocess_workspace.h"
+
+#include <iostream>
+
+#include "cuda_runtime_api.h"
+
+PreprocessWorkspace::~PreprocessWorkspace() {
+  if (m_Buffer) cudaFreeHost(m_Buffer);
+}
+
+bool PreprocessWorkspace::init(const uint32_t maxBatch, const uint32_t inputH,
+                               const uint32_t inputW, const float scale) {
+  if (m_Buffer) cudaFreeHost(m_Buffer);
+  m_Buffer = nullptr;
+  m_Capacity = 0;
+  m_InputH = inputH;
+  m_InputW = inputW;
+  m_Scale = scale;
+  m_Resized.clear();
+  return allocate(maxBatch);
+}
+
+bool PreprocessWorkspace::allocate(const uint32_t batch) {
+  const size_t bytes = size_t(batch) * 3 * m_InputH * m_InputW * sizeof(float);
+  if (cudaMallocHost(reinterpret_cast<void**>(&m_Buffer), bytes) !=
+      cudaSuccess) {
+    std::cout << "cudaMallocHost of the detector input failed !" << std::endl;
+    m_Buffer = nullptr;
+    return false;
+  }
+  m_Capacity = batch;
+  m_Resized.resize(batch);
+  for (auto& resized : m_Resized) {
+    resized.create(m_InputH, m_InputW, CV_8UC3);
+  }
+  return true;
+}
+
+const float* PreprocessWorkspace::process(const std::vector<cv::Mat>& images,
+                                          const size_t first,
+                                          const uint32_t count) {
+  if (count > m_Capacity || first + count > images.size()) {
+    std::cout << "The batch of " << count
+              << " images exceeds the detector input of " << m_Capacity
+              << " !" << std::endl;
+    return nullptr;
+  }
+  for (size_t i = first; i < first + count; ++i) {
+    const cv::Mat& image = images[i];
+    if (!image.data || image.channels() != 3 || image.depth() != CV_8U) {
+      std::cout << "Non RGB images are not supported " << std::endl;
+      return nullptr;
+    }
+  }
+  const cv::Size inputSize(m_InputW, m_InputH);
+  const size_t plane = size_t(m_InputH) * m_InputW;
+
+  cv::parallel_for_(cv::Range(0, count), [&](const cv::Range& range) {
+    for (int i = range.start; i < range.end; ++i) {
+      const cv::Mat& image = images[first + i];
+      // the resized image keeps its buffer, since it already has this size
+      const cv::Mat* resized = &image;
+      if (image.size() != inputSize) {
+        cv::resize(image, m_Resized[i], inputSize, 0, 0, cv::INTER_LINEAR);
+        resized = &m_Resized[i];
+      }
+
+      // bgr hwc uchar -> rgb chw float
+      float* r = m_Buffer + i * 3 * plane;
+      float* g = r + plane;
+      float* b = g + plane;
+      for (uint32_t y = 0; y < m_InputH; ++y) {
+        const uchar* pixel = resized->ptr<uchar>(y);
+        for (uint32_t x = 0; x < m_InputW; ++x, pixel += 3) {
+          *r++ = pixel[2] * m_Scale;
+          *g++ = pixel[1] * m_Scale;
+          *b++ = pixel[0] * m_Scale;
+        }
+      }
+    }
+  });
+  return m_Buffer;
+}
@@ -0,0 +1,51 @@
+#ifndef _PREPROCESS_WORKSPACE_H_
+#define _PREPROCESS_WORKSPACE_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "opencv2/opencv.hpp"
+
+/**
+ * Persistent input buffer of the detector.
+ *
+ * The images of a batch are resized to the network input (cv::resize,
+ * INTER_LINEAR, into scratch images kept between calls), then converted in
+ * one pass from BGR HWC uchar to RGB CHW float multiplied by scale, straight
+ * into a pinned host buffer sized for the max batch, which is uploaded by
+ * Yolo::doInference. It gives the same input as DsImage + blobFromDsImages
+ * without any allocation per frame. The buffer never grows past the max
+ * batch of the engine, a larger batch has to be split by the caller.
+ */
+class PreprocessWorkspace {
+ public:
+  PreprocessWorkspace() = default;
+  ~PreprocessWorkspace();
+  PreprocessWorkspace(const PreprocessWorkspace&) = delete;
+  PreprocessWorkspace& operator=(const PreprocessWorkspace&) = delete;
+
+  // return false if the pinned buffer can not be allocated
+  bool init(const uint32_t maxBatch, const uint32_t inputH,
+            const uint32_t inputW, const float scale = 1.0f);
+
+  // fill the buffer with the count images from images[first], and return it
+  // return nullptr if count is over the capacity or an image is not 8-bit bgr
+  const float* process(const std::vector<cv::Mat>& images, const size_t first,
+                       const uint32_t count);
+
+  const float* data() const { return m_Buffer; }
+  uint32_t capacity() const { return m_Capacity; }
+
+ private:
+  bool allocate(const uint32_t batch);
+
+  uint32_t m_Capacity = 0;  // images the buffer holds
+  uint32_t m_InputH = 0;
+  uint32_t m_InputW = 0;
+  float m_Scale = 1.0f;
+  float* m_Buffer = nullptr;       // pinned, m_Capacity x 3 x m_InputH x m_InputW
+  std::vector<cv::Mat> m_Resized;  // resized image of each batch slot
+};
+
+#endif  // _PREPROCESS_WORKSPACE_H_
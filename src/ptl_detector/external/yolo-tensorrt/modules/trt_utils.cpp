@@ -71,11 +71,6 @@ std::string trimr(std::string s, const char* t) {
   return s;
 }
 
-float clamp(const float val, const float minVal, const float maxVal) {
-  assert(minVal <= maxVal);
-  return std::min(maxVal, std::max(minVal, val));
-}
-
 bool fileExists(const std::string fileName, bool verbose) {
   if (!std::experimental::filesystem::exists(
           std::experimental::filesystem::path(fileName))) {
@@ -107,29 +102,6 @@ BBox convertBBoxNetRes(const float& bx, const float& by, const float& bw,
   return b;
 }
 
-void convertBBoxImgRes(const float scalingFactor,
-                       // const float& xOffset,
-                       //	const float& yOffset,
-                       const uint32_t& input_w_, const uint32_t& input_h_,
-                       const uint32_t& image_w_, const uint32_t& image_h_,
-                       BBox& bbox) {
-  //// Undo Letterbox
-  // bbox.x1 -= xOffset;
-  // bbox.x2 -= xOffset;
-  // bbox.y1 -= yOffset;
-  // bbox.y2 -= yOffset;
-
-  //// Restore to input resolution
-  // bbox.x1 /= scalingFactor;
-  // bbox.x2 /= scalingFactor;
-  // bbox.y1 /= scalingFactor;
-  // bbox.y2 /= scalingFactor;
-  bbox.x1 = ((float)bbox.x1 / (float)input_w_) * (float)image_w_;
-  bbox.y1 = ((float)bbox.y1 / (float)input_h_) * (float)image_h_;
-  bbox.x2 = ((float)bbox.x2 / (float)input_w_) * (float)image_w_;
-  bbox.y2 = ((float)bbox.y2 / (float)input_h_) * (float)image_h_;
-}
-
 void printPredictions(const BBoxInfo& b, const std::string& className) {
   std::cout << " label:" << b.label << "(" << className << ")"
             << " confidence:" << b.prob << " xmin:" << b.box.x1
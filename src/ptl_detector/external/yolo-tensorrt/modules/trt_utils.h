@@ -45,20 +45,9 @@ SOFTWARE.
 #include "hardswish.h"
 #include "mish.h"
 #include "plugin_factory.h"
+#include "yolo_types.h"
 //#include "logging.h"
 class DsImage;
-struct BBox
-{
-    float x1, y1, x2, y2;
-};
-
-struct BBoxInfo
-{
-    BBox box;
-    int label;
-    int classId; // For coco benchmarking
-    float prob;
-};
 
 class Logger : public nvinfer1::ILogger
 {
@@ -140,17 +129,10 @@ cv::Mat blobFromDsImages(const std::vector<DsImage> &inputImages,
 std::string trim(std::string s);
 std::string triml(std::string s, const char *t);
 std::string trimr(std::string s, const char *t);
-float clamp(const float val, const float minVal, const float maxVal);
 bool fileExists(const std::string fileName, bool verbose = true);
 BBox convertBBoxNetRes(const float &bx, const float &by, const float &bw,
                        const float &bh, const uint32_t &stride,
                        const uint32_t &netW, const uint32_t &netH);
-void convertBBoxImgRes(const float scalingFactor,
-                       // const float& xOffset,
-                       //	const float& yOffset,
-                       const uint32_t &input_w_, const uint32_t &input_h_,
-                       const uint32_t &image_w_, const uint32_t &image_h_,
-                       BBox &bbox);
 void printPredictions(const BBoxInfo &info, const std::string &className);
 std::vector<std::string> loadListFromTextFile(const std::string filename);
 std::vector<std::string> loadImageList(const std::string filename,
@@ -41,6 +41,7 @@ Yolo::Yolo(const NetworkInfo& networkInfo, const InferParams& inferParams)
       m_TinyMaxpoolPaddingFormula(new YoloTinyMaxpoolPaddingFormula),
       _n_yolo_ind(0) {
   // m_ClassNames = loadListFromTextFile(m_LabelsFilePath);
+  m_Decoder.setProbThresh(m_ProbThresh);
 
   m_configBlocks = parseConfigFile(m_ConfigFilePath);
   if (m_NetworkType == "yolov5") {
@@ -876,12 +877,25 @@ std::vector<BBoxInfo> Yolo::decodeDetections(const int& imageIdx,
                                              const int& imageH,
                                              const int& imageW) {
   std::vector<BBoxInfo> binfo;
+  decodeDetections(imageIdx, imageH, imageW, binfo);
+  return binfo;
+}
+
+void Yolo::decodeDetections(const int& imageIdx, const int& imageH,
+                            const int& imageW, std::vector<BBoxInfo>& binfo) {
+  binfo.clear();
+  binfo.reserve(YoloDecoder::maxProposals(m_OutputTensors));
   for (auto& tensor : m_OutputTensors) {
-    std::vector<BBoxInfo> curBInfo =
-        decodeTensor(imageIdx, imageH, imageW, tensor);
-    binfo.insert(binfo.end(), curBInfo.begin(), curBInfo.end());
+    decodeTensor(imageIdx, imageH, imageW, tensor, binfo);
   }
-  return binfo;
+}
+
+void Yolo::decodeTensor(const int imageIdx, const int imageH,
+                        const int imageW, const TensorInfo& tensor,
+                        std::vector<BBoxInfo>& binfo) {
+  std::vector<BBoxInfo> curBInfo =
+      decodeTensor(imageIdx, imageH, imageW, tensor);
+  binfo.insert(binfo.end(), curBInfo.begin(), curBInfo.end());
 }
 
 std::vector<std::map<std::string, std::string>> Yolo::parseConfigFile(
@@ -1173,4 +1187,11 @@ void Yolo::setNmsThresh(float m_nms_thresh) { m_NMSThresh = m_nms_thresh; }
 
 float Yolo::getProbThresh() const { return m_ProbThresh; }
 
-void Yolo::setProbThresh(float m_prob_thresh) { m_ProbThresh = m_prob_thresh; }
+void Yolo::setProbThresh(float m_prob_thresh) {
+  m_ProbThresh = m_prob_thresh;
+  m_Decoder.setProbThresh(m_prob_thresh);
+}
+
+void Yolo::setClassWhitelist(const std::vector<uint32_t>& classWhitelist) {
+  m_Decoder.setClassWhitelist(classWhitelist);
+}
@@ -41,6 +41,8 @@ SOFTWARE.
 #include "opencv2/opencv.hpp"
 #include "plugin_factory.h"
 #include "trt_utils.h"
+#include "yolo_decoder.h"
+#include "yolo_types.h"
 //#include "logging.h"
 
 /**
@@ -71,26 +73,6 @@ struct InferParams {
   float nmsThresh;
 };
 
-/**
- * Holds information about an output tensor of the yolo network.
- */
-struct TensorInfo {
-  std::string blobName;
-  uint32_t stride{0};
-  uint32_t stride_h{0};
-  uint32_t stride_w{0};
-  uint32_t gridSize{0};
-  uint32_t grid_h{0};
-  uint32_t grid_w{0};
-  uint32_t numClasses{0};
-  uint32_t numBBoxes{0};
-  uint64_t volume{0};
-  std::vector<uint32_t> masks;
-  std::vector<float> anchors;
-  int bindingIndex{-1};
-  float* hostBuffer{nullptr};
-};
-
 class Yolo {
  public:
   std::string getNetworkType() const { return m_NetworkType; }
@@ -112,6 +94,12 @@ class Yolo {
   void doInference(const unsigned char* input, const uint32_t batchSize);
   std::vector<BBoxInfo> decodeDetections(const int& imageIdx, const int& imageH,
                                          const int& imageW);
+  // decode into a buffer kept by the caller, which is cleared first and
+  // reserved for the largest possible output, so it is allocated only once
+  void decodeDetections(const int& imageIdx, const int& imageH,
+                        const int& imageW, std::vector<BBoxInfo>& binfo);
+  // keep only these classes in the detections of yolov3/v4/v5, empty keeps all
+  void setClassWhitelist(const std::vector<uint32_t>& classWhitelist);
 
   virtual ~Yolo();
 
@@ -166,6 +154,13 @@ class Yolo {
   virtual std::vector<BBoxInfo> decodeTensor(const int imageIdx,
                                              const int imageH, const int imageW,
                                              const TensorInfo& tensor) = 0;
+  // append the detections of a tensor to binfo, the networks with the
+  // yolov3 output layout override it with the vectorized YoloDecoder, and
+  // yolov2 decodes straight into binfo
+  virtual void decodeTensor(const int imageIdx, const int imageH,
+                            const int imageW, const TensorInfo& tensor,
+                            std::vector<BBoxInfo>& binfo);
+  YoloDecoder m_Decoder{m_ClassIds};
 
   inline void addBBoxProposal(const float bx, const float by, const float bw,
                               const float bh, const uint32_t stride,
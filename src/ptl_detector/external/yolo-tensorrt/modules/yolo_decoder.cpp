@@ -0,0 +1,129 @@
+#include "yolo_decoder.h"
+
+#include <algorithm>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+#include "yolo_types.h"
+
+namespace {
+
+// append the indices of the values greater than thresh
+void collectAbove(const float* values, const uint32_t n, const float thresh,
+                  std::vector<uint32_t>& indices) {
+  uint32_t i = 0;
+#if defined(__SSE2__)
+  const __m128 t = _mm_set1_ps(thresh);
+  for (; i + 8 <= n; i += 8) {
+    int mask =
+        _mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(values + i), t)) |
+        (_mm_movemask_ps(_mm_cmpgt_ps(_mm_loadu_ps(values + i + 4), t)) << 4);
+    while (mask) {
+      indices.push_back(i + __builtin_ctz(mask));
+      mask &= mask - 1;
+    }
+  }
+#elif defined(__ARM_NEON) && defined(__aarch64__)
+  const float32x4_t t = vdupq_n_f32(thresh);
+  for (; i + 8 <= n; i += 8) {
+    const uint32x4_t mask = vorrq_u32(vcgtq_f32(vld1q_f32(values + i), t),
+                                      vcgtq_f32(vld1q_f32(values + i + 4), t));
+    if (vmaxvq_u32(mask) == 0) continue;
+    for (uint32_t k = i; k < i + 8; ++k) {
+      if (values[k] > thresh) indices.push_back(k);
+    }
+  }
+#endif
+  for (; i < n; ++i) {
+    if (values[i] > thresh) indices.push_back(i);
+  }
+}
+
+}  // namespace
+
+size_t YoloDecoder::maxProposals(const std::vector<TensorInfo>& tensors) {
+  size_t num = 0;
+  for (const auto& tensor : tensors) {
+    num += tensor.grid_h * tensor.grid_w * tensor.numBBoxes;
+  }
+  return num;
+}
+
+void YoloDecoder::decode(const float* detections, const TensorInfo& tensor,
+                         const uint32_t netW, const uint32_t netH,
+                         const uint32_t imageW, const uint32_t imageH,
+                         std::vector<BBoxInfo>& binfo) {
+  const uint32_t numGridCells = tensor.grid_h * tensor.grid_w;
+  const uint32_t numChannels = 5 + tensor.numClasses;
+  m_Survivors.reserve(numGridCells);
+
+  for (uint32_t b = 0; b < tensor.numBBoxes; ++b) {
+    const float pw = tensor.anchors[tensor.masks[b] * 2];
+    const float ph = tensor.anchors[tensor.masks[b] * 2 + 1];
+    const float* plane = detections + numGridCells * b * numChannels;
+    const float* objectnessPlane = plane + numGridCells * 4;
+    const float* classPlane = plane + numGridCells * 5;
+
+    m_Survivors.clear();
+    collectAbove(objectnessPlane, numGridCells, m_ProbThresh, m_Survivors);
+
+    for (const uint32_t cell : m_Survivors) {
+      const float objectness = objectnessPlane[cell];
+
+      // the best whitelisted class has to pass the threshold on its own
+      if (!m_ClassWhitelist.empty()) {
+        float maxWhitelisted = 0.0f;
+        for (const uint32_t c : m_ClassWhitelist) {
+          if (c < tensor.numClasses) {
+            maxWhitelisted =
+                std::max(maxWhitelisted, classPlane[numGridCells * c + cell]);
+          }
+        }
+        if (objectness * maxWhitelisted <= m_ProbThresh) continue;
+      }
+
+      float maxProb = 0.0f;
+      int maxIndex = -1;
+      for (uint32_t i = 0; i < tensor.numClasses; ++i) {
+        const float prob = classPlane[numGridCells * i + cell];
+        if (prob > maxProb) {
+          maxProb = prob;
+          maxIndex = i;
+        }
+      }
+      maxProb = objectness * maxProb;
+      if (maxProb <= m_ProbThresh) continue;
+      if (!m_ClassWhitelist.empty() &&
+          std::find(m_ClassWhitelist.begin(), m_ClassWhitelist.end(),
+                    static_cast<uint32_t>(maxIndex)) == m_ClassWhitelist.end()) {
+        continue;
+      }
+
+      // restore the box to the network input resolution, then to the image
+      const uint32_t x = cell % tensor.grid_w;
+      const uint32_t y = cell / tensor.grid_w;
+      const float bx = (x + plane[cell]) * tensor.stride_w;
+      const float by = (y + plane[numGridCells + cell]) * tensor.stride_h;
+      const float bw = pw * plane[numGridCells * 2 + cell];
+      const float bh = ph * plane[numGridCells * 3 + cell];
+
+      BBoxInfo bbi;
+      bbi.box.x1 = clamp(bx - bw / 2, 0, netW);
+      bbi.box.x2 = clamp(bx + bw / 2, 0, netW);
+      bbi.box.y1 = clamp(by - bh / 2, 0, netH);
+      bbi.box.y2 = clamp(by + bh / 2, 0, netH);
+      if ((bbi.box.x1 > bbi.box.x2) || (bbi.box.y1 > bbi.box.y2)) continue;
+      convertBBoxImgRes(0, netW, netH, imageW, imageH, bbi.box);
+      bbi.label = maxIndex;
+      bbi.prob = maxProb;
+      bbi.classId = static_cast<uint32_t>(maxIndex) < m_ClassIds.size()
+                        ? m_ClassIds[maxIndex]
+                        : maxIndex;
+      binfo.push_back(bbi);
+    }
+  }
+}
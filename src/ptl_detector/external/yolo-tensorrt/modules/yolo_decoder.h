@@ -0,0 +1,49 @@
+#ifndef _YOLO_DECODER_H_
+#define _YOLO_DECODER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "yolo_types.h"
+
+/**
+ * Decodes the output layers of yolov3/v4/v5 on the host buffers.
+ *
+ * The layer output is planar: for each anchor, 5 + numClasses planes of
+ * grid_h x grid_w (x, y, w, h, objectness, class probabilities). Since the
+ * class probabilities are at most 1, a cell can only pass the threshold if
+ * its objectness does, so the objectness plane of each anchor is thresholded
+ * first (8 cells at a time with SSE/NEON) and the class argmax is only done
+ * for the surviving cells. The proposals are appended to a buffer owned by the
+ * caller, which is reserved once for the largest possible output.
+ */
+class YoloDecoder {
+ public:
+  explicit YoloDecoder(const std::vector<int>& classIds = {})
+      : m_ClassIds(classIds) {}
+
+  void setProbThresh(const float probThresh) { m_ProbThresh = probThresh; }
+  float getProbThresh() const { return m_ProbThresh; }
+
+  // keep only the proposals whose best class is one of these, empty keeps all
+  void setClassWhitelist(const std::vector<uint32_t>& classWhitelist) {
+    m_ClassWhitelist = classWhitelist;
+  }
+
+  // the number of proposals of an image at most, one per cell and anchor
+  static size_t maxProposals(const std::vector<TensorInfo>& tensors);
+
+  // decode the output of one layer of one image and append to binfo
+  void decode(const float* detections, const TensorInfo& tensor,
+              const uint32_t netW, const uint32_t netH, const uint32_t imageW,
+              const uint32_t imageH, std::vector<BBoxInfo>& binfo);
+
+ private:
+  std::vector<int> m_ClassIds;  // class id of each label for coco benchmarking
+  float m_ProbThresh = 0.5f;
+  std::vector<uint32_t> m_ClassWhitelist;
+  std::vector<uint32_t> m_Survivors;  // cells of an anchor passing objectness
+};
+
+#endif  // _YOLO_DECODER_H_
@@ -0,0 +1,58 @@
+#ifndef _YOLO_TYPES_H_
+#define _YOLO_TYPES_H_
+
+#include <stdint.h>
+
+#include <string>
+#include <vector>
+
+/**
+ * The proposals and the output layer description of the yolo networks, used
+ * by the decoding and the nms on the host. They need neither TensorRT nor
+ * CUDA, so the cpu detector shares them through yolo_postprocess.
+ */
+
+struct BBox
+{
+    float x1, y1, x2, y2;
+};
+
+struct BBoxInfo
+{
+    BBox box;
+    int label;
+    int classId; // For coco benchmarking
+    float prob;
+};
+
+/**
+ * Holds information about an output tensor of the yolo network.
+ */
+struct TensorInfo {
+  std::string blobName;
+  uint32_t stride{0};
+  uint32_t stride_h{0};
+  uint32_t stride_w{0};
+  uint32_t gridSize{0};
+  uint32_t grid_h{0};
+  uint32_t grid_w{0};
+  uint32_t numClasses{0};
+  uint32_t numBBoxes{0};
+  uint64_t volume{0};
+  std::vector<uint32_t> masks;
+  std::vector<float> anchors;
+  int bindingIndex{-1};
+  float* hostBuffer{nullptr};
+};
+
+float clamp(const float val, const float minVal, const float maxVal);
+
+// scale a bbox from the network input to the image
+void convertBBoxImgRes(const float scalingFactor,
+                       // const float& xOffset,
+                       //	const float& yOffset,
+                       const uint32_t &input_w_, const uint32_t &input_h_,
+                       const uint32_t &image_w_, const uint32_t &image_h_,
+                       BBox &bbox);
+
+#endif  // _YOLO_TYPES_H_
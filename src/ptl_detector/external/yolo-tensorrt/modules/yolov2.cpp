@@ -33,6 +33,14 @@ YoloV2::YoloV2(const NetworkInfo& networkInfo, const InferParams& inferParams)
 std::vector<BBoxInfo> YoloV2::decodeTensor(const int imageIdx, const int imageH,
                                            const int imageW,
                                            const TensorInfo& tensor) {
+  std::vector<BBoxInfo> binfo;
+  decodeTensor(imageIdx, imageH, imageW, tensor, binfo);
+  return binfo;
+}
+
+void YoloV2::decodeTensor(const int imageIdx, const int imageH, const int imageW,
+                          const TensorInfo& tensor,
+                          std::vector<BBoxInfo>& binfo) {
   float scalingFactor = std::min(static_cast<float>(m_InputW) / imageW,
                                  static_cast<float>(m_InputH) / imageH);
   float xOffset = (m_InputW - scalingFactor * imageW) / 2;
@@ -40,7 +48,6 @@ std::vector<BBoxInfo> YoloV2::decodeTensor(const int imageIdx, const int imageH,
 
   float* detections = &tensor.hostBuffer[imageIdx * tensor.volume];
 
-  std::vector<BBoxInfo> binfo;
   for (uint32_t y = 0; y < tensor.gridSize; y++) {
     for (uint32_t x = 0; x < tensor.gridSize; x++) {
       for (uint32_t b = 0; b < tensor.numBBoxes; b++) {
@@ -89,5 +96,4 @@ std::vector<BBoxInfo> YoloV2::decodeTensor(const int imageIdx, const int imageH,
       }
     }
   }
-  return binfo;
 }
@@ -41,6 +41,8 @@ class YoloV3 : public Yolo {
   std::vector<BBoxInfo> decodeTensor(const int imageIdx, const int imageH,
                                      const int imageW,
                                      const TensorInfo& tensor) override;
+  void decodeTensor(const int imageIdx, const int imageH, const int imageW,
+                    const TensorInfo& tensor, std::vector<BBoxInfo>& binfo) override;
 };
 
 #endif  // _YOLO_V3_
\ No newline at end of file
@@ -9,6 +9,8 @@ class YoloV4 : public Yolo {
   std::vector<BBoxInfo> decodeTensor(const int imageIdx, const int imageH,
                                      const int imageW,
                                      const TensorInfo &tensor) override;
+  void decodeTensor(const int imageIdx, const int imageH, const int imageW,
+                    const TensorInfo &tensor, std::vector<BBoxInfo> &binfo) override;
 };
 
 #endif
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <memory>
+#include <string>
+
+#include "ptl_detector/detector/yolo_object_detector.h"
+
+namespace ptl
+{
+    namespace detector
+    {
+
+        //create and init the detector of a backend: "tensorrt" on the GPU, or "cpu" with the OpenCV DNN module
+        //return nullptr if it can not be initialized, or if ptl_detector is built without TensorRT and "tensorrt" is asked
+        std::unique_ptr<BaseObjectDetector> CreateObjectDetector(const std::string &backend, const Config &config);
+
+    } // namespace detector
+} // namespace ptl
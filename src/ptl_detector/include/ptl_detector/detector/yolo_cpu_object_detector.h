@@ -0,0 +1,40 @@
+#pragma once
+
+#include <memory>
+
+#include "ptl_detector/detector/yolo_object_detector.h"
+
+namespace ptl
+{
+    namespace detector
+    {
+
+        //yolov3/v4 (and the tiny ones) on the CPU with the OpenCV DNN module, for the machines without a GPU
+        //the darknet cfg/weights are loaded as they are, the raw outputs of the convolutions before the yolo layers
+        //go through the same decoding and nms as the TensorRT detector, so both backends give the same detections
+        class YoloCpuObjectDetector : public BaseObjectDetector
+        {
+        public:
+            YoloCpuObjectDetector();
+            ~YoloCpuObjectDetector() override;
+
+            bool Init() override;
+            bool Init(const Config &config);
+            using BaseObjectDetector::Detect;
+            bool Detect(const cv::Mat &frame,
+                        std::vector<ObjectDetectionResult> &results) override;
+            void Infer() override {}
+
+            void SetProbThresh(float m_prob_thresh);
+            void SetWidthLimitation(float min_value, float max_value);
+            void SetHeightLimitation(float min_value, float max_value);
+
+        private:
+            struct Impl;
+
+            Config config_;
+            std::unique_ptr<Impl> impl_;
+        };
+
+    } // namespace detector
+} // namespace ptl
@@ -19,18 +19,23 @@ namespace ptl
             bool Detect(const cv::Mat &frame,
                         std::vector<ObjectDetectionResult> &results) override;
             bool Detect(const std::vector<cv::Mat> &batch_frames,
-                        std::vector<std::vector<ObjectDetectionResult>> &batch_results);
+                        std::vector<std::vector<ObjectDetectionResult>> &batch_results) override;
             void Infer() override {}
 
             void SetProbThresh(float m_prob_thresh);
             void SetWidthLimitation(float min_value, float max_value);
             void SetHeightLimitation(float min_value, float max_value);
 
+            // read the config from /ptl_detector/object_detector, shared by the detector backends
+            static bool LoadConfig(Config &config);
+
         private:
             void FilterResults(BatchResult &results);
 
             Config config_;
             std::shared_ptr<Detector> detector_;
+            std::vector<cv::Mat> batch_frames_;           // input of Detect(frame), reused between frames
+            std::vector<BatchResult> batch_results_raw_;  // output of the detector, reused between frames and batches
         };
 
     } // namespace detector
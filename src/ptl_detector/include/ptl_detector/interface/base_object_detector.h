@@ -27,6 +27,20 @@ namespace ptl
             void Infer() override = 0;
             virtual bool Detect(const cv::Mat &frame,
                                 std::vector<ObjectDetectionResult> &result) = 0;
+            // append the results of each frame to batch_results, the detectors without batch inference run the frames one by one
+            virtual bool Detect(const std::vector<cv::Mat> &batch_frames,
+                                std::vector<std::vector<ObjectDetectionResult>> &batch_results)
+            {
+                for (const auto &frame : batch_frames)
+                {
+                    batch_results.emplace_back();
+                    if (!Detect(frame, batch_results.back()))
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
         };
 
     } // namespace detector
@@ -1,4 +1,7 @@
+#include <stdexcept>
+
 #include "ptl_detector/util/util.h"
+#include "ptl_detector/detector/object_detector_factory.h"
 #include "opencv2/opencv.hpp"
 namespace ptl
 {
@@ -12,6 +15,7 @@ namespace ptl
 
             string lidar_topic, camera_topic, depth_topic;
 
+            string cam_backend = "tensorrt"; // "tensorrt" on the GPU, or "cpu" with the OpenCV DNN module
             string cam_net_type = "YOLOV4_TINY";
             string cam_file_model_cfg;
             string cam_file_model_weights;
@@ -22,11 +26,18 @@ namespace ptl
             float cam_prob_threshold = 0.5;
             float cam_min_height = 0;
             float cam_max_height = 480;
+            std::vector<int> cam_class_whitelist = {0}; // only person is used, empty to detect all the classes
+            int cam_nms_top_k = 300;                    // proposals of the highest score going into nms, 0 for all
+            bool cam_roi_detection = false;             // detect in the regions around the tracking objects instead of the full frame
+            int cam_roi_full_frame_every_k = 5;         // in roi detection, one detection of every k is still on the full frame, for the new objects
+            float cam_roi_padding = 0.5;                // the padding of a region on each side, as a ratio of the size of the tracking object
+            float cam_roi_max_area_ratio = 0.6;         // detect on the full frame if the regions cover more than this ratio of it
         };
 
         class YoloPedestrainDetector
         {
         public:
+            // throw std::runtime_error if the detector of cam_backend can not be initialized
             YoloPedestrainDetector(const ros::NodeHandle &n) : nh_(n)
             {
                 loadConfig(n);
@@ -41,53 +52,177 @@ namespace ptl
                 config_cam.max_width = config.cam_max_width;
                 config_cam.min_height = config.cam_min_height;
                 config_cam.max_height = config.cam_max_height;
-                detector.Init(config_cam);
+                config_cam.class_whitelist = config.cam_class_whitelist;
+                config_cam.nms_top_k = config.cam_nms_top_k;
+                detector = CreateObjectDetector(config.cam_backend, config_cam);
+                if (!detector)
+                {
+                    throw std::runtime_error("cannot init the " + config.cam_backend + " detector!");
+                }
             }
 
             void detect_pedestrain(const cv::Mat &image)
             {
                 results.clear();
-                detector.Detect(image, results);
-                result_vis = image.clone();
-                for (auto r : results)
+                rois.clear();
+                detector->Detect(image, results);
+                visualize(image);
+            }
+
+            // in roi detection, only detect in the padded regions around the tracking objects (track_bboxes),
+            // the regions are cropped from the image and detected in batches, then the results are mapped back to the image
+            void detect_pedestrain(const cv::Mat &image, const std::vector<cv::Rect2d> &track_bboxes)
+            {
+                bool full_frame = !config.cam_roi_detection || track_bboxes.empty() ||
+                                  detection_count_since_full_frame + 1 >= config.cam_roi_full_frame_every_k ||
+                                  !make_rois(image.size(), track_bboxes);
+                if (full_frame)
                 {
-                    cv::Scalar draw_color;
-                    string text;
-                    if (r.type == 0)
+                    detection_count_since_full_frame = 0;
+                    detect_pedestrain(image);
+                    return;
+                }
+                detection_count_since_full_frame++;
+
+                roi_images.clear();
+                for (const auto &roi : rois)
+                {
+                    roi_images.push_back(image(roi));
+                }
+                roi_results.clear();
+                const size_t batch_size = std::max(1, config.cam_n_max_batch);
+                for (size_t begin = 0; begin < roi_images.size(); begin += batch_size)
+                {
+                    const size_t end = std::min(roi_images.size(), begin + batch_size);
+                    roi_batch.assign(roi_images.begin() + begin, roi_images.begin() + end);
+                    detector->Detect(roi_batch, roi_results);
+                }
+
+                results.clear();
+                for (size_t i = 0; i < roi_results.size() && i < rois.size(); i++)
+                {
+                    for (const auto &r : roi_results[i])
                     {
-                        text = "pedestrain: " + to_string(r.prob);
-                        draw_color = cv::Scalar(0, 255, 0);
-                        cv::rectangle(result_vis, r.bbox, draw_color, 5.0);
-                        cv::putText(result_vis, text, cv::Point(r.bbox.x, r.bbox.y), cv::FONT_HERSHEY_COMPLEX, 1.5, draw_color, 6.0);
+                        cv::Rect bbox = r.bbox + rois[i].tl();
+                        if (!is_cut_by_roi(bbox, rois[i], image.size()))
+                        {
+                            results.emplace_back(bbox, r.type, r.prob);
+                        }
                     }
                 }
+                visualize(image);
             }
 
             void loadConfig(const ros::NodeHandle &n)
             {
+                n.getParam("/cam/cam_backend", config.cam_backend);
                 n.getParam("/cam/cam_net_type", config.cam_net_type);
                 n.getParam("/cam/cam_file_model_cfg", config.cam_file_model_cfg);
                 n.getParam("/cam/cam_file_model_weights", config.cam_file_model_weights);
                 n.getParam("/cam/cam_inference_precison", config.cam_inference_precison);
-                n.getParam("/cam/cam_n_max_batch", config.cam_file_model_cfg);
+                n.getParam("/cam/cam_n_max_batch", config.cam_n_max_batch);
                 n.getParam("/cam/cam_prob_threshold", config.cam_prob_threshold);
                 n.getParam("/cam/cam_min_width", config.cam_min_width);
                 n.getParam("/cam/cam_max_width", config.cam_max_width);
                 n.getParam("/cam/cam_min_height", config.cam_min_height);
                 n.getParam("/cam/cam_max_height", config.cam_max_height);
+                n.getParam("/cam/cam_class_whitelist", config.cam_class_whitelist);
+                n.getParam("/cam/cam_nms_top_k", config.cam_nms_top_k);
+                n.getParam("/cam/cam_roi_detection", config.cam_roi_detection);
+                n.getParam("/cam/cam_roi_full_frame_every_k", config.cam_roi_full_frame_every_k);
+                n.getParam("/cam/cam_roi_padding", config.cam_roi_padding);
+                n.getParam("/cam/cam_roi_max_area_ratio", config.cam_roi_max_area_ratio);
             }
 
         public:
             cv::Mat result_vis;
             std::vector<ObjectDetectionResult> results;
 
+        private:
+            void visualize(const cv::Mat &image)
+            {
+                result_vis = image.clone();
+                for (const auto &roi : rois)
+                {
+                    cv::rectangle(result_vis, roi, cv::Scalar(255, 0, 0), 2.0);
+                }
+                for (auto r : results)
+                {
+                    cv::Scalar draw_color;
+                    string text;
+                    if (r.type == 0)
+                    {
+                        text = "pedestrain: " + to_string(r.prob);
+                        draw_color = cv::Scalar(0, 255, 0);
+                        cv::rectangle(result_vis, r.bbox, draw_color, 5.0);
+                        cv::putText(result_vis, text, cv::Point(r.bbox.x, r.bbox.y), cv::FONT_HERSHEY_COMPLEX, 1.5, draw_color, 6.0);
+                    }
+                }
+            }
+
+            // pad the bboxes of the tracking objects into regions, and merge the overlapping ones so that an object is only in one region
+            // return false if the regions are too large to be worth it
+            bool make_rois(const cv::Size &image_size, const std::vector<cv::Rect2d> &track_bboxes)
+            {
+                const cv::Rect frame(cv::Point(0, 0), image_size);
+                rois.clear();
+                for (const auto &b : track_bboxes)
+                {
+                    const double pad_x = b.width * config.cam_roi_padding, pad_y = b.height * config.cam_roi_padding;
+                    cv::Rect roi = cv::Rect2d(b.x - pad_x, b.y - pad_y, b.width + 2 * pad_x, b.height + 2 * pad_y);
+                    roi &= frame;
+                    if (roi.area() > 0)
+                    {
+                        rois.push_back(roi);
+                    }
+                }
+                for (bool merged = true; merged;)
+                {
+                    merged = false;
+                    for (size_t i = 0; i < rois.size() && !merged; i++)
+                    {
+                        for (size_t j = i + 1; j < rois.size() && !merged; j++)
+                        {
+                            if ((rois[i] & rois[j]).area() > 0)
+                            {
+                                rois[i] |= rois[j];
+                                rois.erase(rois.begin() + j);
+                                merged = true;
+                            }
+                        }
+                    }
+                }
+                double area = 0;
+                for (const auto &roi : rois)
+                {
+                    area += roi.area();
+                }
+                return !rois.empty() && area <= config.cam_roi_max_area_ratio * frame.area();
+            }
+
+            // a bbox on an edge of the region which is not the image edge is an object cut by the region, it is left to the full frame detection
+            bool is_cut_by_roi(const cv::Rect &bbox, const cv::Rect &roi, const cv::Size &image_size) const
+            {
+                const int margin = 2;
+                return (roi.x > 0 && bbox.x <= roi.x + margin) ||
+                       (roi.y > 0 && bbox.y <= roi.y + margin) ||
+                       (roi.br().x < image_size.width && bbox.br().x >= roi.br().x - margin) ||
+                       (roi.br().y < image_size.height && bbox.br().y >= roi.br().y - margin);
+            }
+
         private:
             ros::NodeHandle nh_;
 
             YoloParam config;
             Config config_cam;
             std::string package_path;
-            YoloObjectDetector detector;
+            std::unique_ptr<BaseObjectDetector> detector;
+
+            // roi detection
+            int detection_count_since_full_frame = 0;
+            std::vector<cv::Rect> rois;                                  // regions of the last detection, empty for the full frame
+            std::vector<cv::Mat> roi_images, roi_batch;                  // crops of the regions, reused between detections
+            std::vector<std::vector<ObjectDetectionResult>> roi_results; // results of each region, in the region coordinates
         };
     } // namespace detector
 } // namespace ptl
@@ -0,0 +1,42 @@
+#include "ptl_detector/detector/object_detector_factory.h"
+
+#include "ptl_detector/detector/yolo_cpu_object_detector.h"
+#include "ptl_detector/util/log.h"
+
+namespace ptl
+{
+    namespace detector
+    {
+
+        std::unique_ptr<BaseObjectDetector> CreateObjectDetector(const std::string &backend, const Config &config)
+        {
+            if (backend == "cpu")
+            {
+                YoloCpuObjectDetector *cpu_detector = new YoloCpuObjectDetector();
+                std::unique_ptr<BaseObjectDetector> detector(cpu_detector);
+                if (!cpu_detector->Init(config))
+                {
+                    return nullptr;
+                }
+                return detector;
+            }
+            if (backend != "tensorrt")
+            {
+                AWARN << "Unknown detector backend " << backend << ", use tensorrt";
+            }
+#ifdef PTL_DETECTOR_WITH_TENSORRT
+            YoloObjectDetector *trt_detector = new YoloObjectDetector();
+            std::unique_ptr<BaseObjectDetector> detector(trt_detector);
+            if (!trt_detector->Init(config))
+            {
+                return nullptr;
+            }
+            return detector;
+#else
+            AERROR << "ptl_detector is built without TensorRT, use the cpu backend";
+            return nullptr;
+#endif
+        }
+
+    } // namespace detector
+} // namespace ptl
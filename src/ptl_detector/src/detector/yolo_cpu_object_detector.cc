@@ -0,0 +1,314 @@
+#include "ptl_detector/detector/yolo_cpu_object_detector.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cmath>
+#include <fstream>
+#include <map>
+#include <sstream>
+#include <string>
+
+#include "nms_engine.h"
+#include "opencv2/dnn.hpp"
+#include "ptl_detector/util/log.h"
+#include "yolo_types.h"
+#include "yolo_decoder.h"
+
+namespace ptl
+{
+    namespace detector
+    {
+
+        namespace
+        {
+            typedef std::map<std::string, std::string> CfgBlock;
+
+            //the same as trim of trt_utils, which is not built without TensorRT
+            std::string Trim(const std::string &s)
+            {
+                const auto begin = std::find_if(s.begin(), s.end(), [](int ch) { return !std::isspace(ch); });
+                const auto end = std::find_if(s.rbegin(), s.rend(), [](int ch) { return !std::isspace(ch); }).base();
+                return begin < end ? std::string(begin, end) : std::string();
+            }
+
+            //the sections of a darknet cfg in order, the same way as Yolo::parseConfigFile
+            std::vector<CfgBlock> ParseCfg(const std::string &cfg_path)
+            {
+                std::vector<CfgBlock> blocks;
+                std::ifstream file(cfg_path);
+                std::string line;
+                while (std::getline(file, line))
+                {
+                    line = Trim(line);
+                    if (line.empty() || line.front() == '#')
+                    {
+                        continue;
+                    }
+                    if (line.front() == '[')
+                    {
+                        blocks.emplace_back();
+                        blocks.back()["type"] = Trim(line.substr(1, line.size() - 2));
+                    }
+                    else if (!blocks.empty())
+                    {
+                        const size_t pos = line.find('=');
+                        blocks.back()[Trim(line.substr(0, pos))] = Trim(line.substr(pos + 1));
+                    }
+                }
+                return blocks;
+            }
+
+            template <typename T, typename Convert>
+            std::vector<T> ParseList(const std::string &value, Convert convert)
+            {
+                std::vector<T> list;
+                std::stringstream stream(value);
+                std::string item;
+                while (std::getline(stream, item, ','))
+                {
+                    if (!Trim(item).empty())
+                    {
+                        list.push_back(convert(Trim(item)));
+                    }
+                }
+                return list;
+            }
+
+            inline float Sigmoid(const float x)
+            {
+                return 1.0f / (1.0f + std::exp(-x));
+            }
+
+            //apply the activations of the TensorRT yolo plugin to a raw convolution output in place:
+            //sigmoid on x, y, objectness and the class scores, exp on w and h
+            //the decoder only reads the cells whose objectness passes the threshold, so the other cells only get their objectness
+            void Activate(float *output, const TensorInfo &tensor, const float prob_thresh)
+            {
+                const uint32_t cell_num = tensor.grid_h * tensor.grid_w;
+                const uint32_t channel_num = 5 + tensor.numClasses;
+                for (uint32_t b = 0; b < tensor.numBBoxes; ++b)
+                {
+                    float *plane = output + cell_num * channel_num * b;
+                    float *objectness = plane + cell_num * 4;
+                    for (uint32_t cell = 0; cell < cell_num; ++cell)
+                    {
+                        objectness[cell] = Sigmoid(objectness[cell]);
+                        if (objectness[cell] <= prob_thresh)
+                        {
+                            continue;
+                        }
+                        plane[cell] = Sigmoid(plane[cell]);
+                        plane[cell_num + cell] = Sigmoid(plane[cell_num + cell]);
+                        plane[cell_num * 2 + cell] = std::exp(plane[cell_num * 2 + cell]);
+                        plane[cell_num * 3 + cell] = std::exp(plane[cell_num * 3 + cell]);
+                        for (uint32_t c = 0; c < tensor.numClasses; ++c)
+                        {
+                            float &score = plane[cell_num * (5 + c) + cell];
+                            score = Sigmoid(score);
+                        }
+                    }
+                }
+            }
+        } // namespace
+
+        struct YoloCpuObjectDetector::Impl
+        {
+            cv::dnn::Net net;
+            uint32_t input_w = 0;
+            uint32_t input_h = 0;
+            std::vector<std::string> output_names; // the convolutions before the yolo layers
+            std::vector<TensorInfo> tensors;       // one for each yolo layer
+            cv::Mat blob;                          // network input, reused between frames
+            std::vector<cv::Mat> outputs;          // raw convolution outputs, reused between frames
+            YoloDecoder decoder;
+            NmsEngine nms;
+            NmsType nms_type = NmsType::kIoU;
+            float nms_thresh = 0.5;                // the same as the TensorRT detector
+            std::vector<BBoxInfo> proposals;       // decoded detections of a frame, reused between frames
+            std::vector<BBoxInfo> detections;      // detections after nms
+        };
+
+        YoloCpuObjectDetector::YoloCpuObjectDetector() = default;
+
+        YoloCpuObjectDetector::~YoloCpuObjectDetector() = default;
+
+        bool YoloCpuObjectDetector::Init()
+        {
+            Config config;
+            if (!YoloObjectDetector::LoadConfig(config))
+            {
+                return false;
+            }
+            return Init(config);
+        }
+
+        bool YoloCpuObjectDetector::Init(const Config &config)
+        {
+            // copy config
+            config_ = config;
+            if (config_.net_type != YOLOV3 && config_.net_type != YOLOV3_TINY &&
+                config_.net_type != YOLOV4 && config_.net_type != YOLOV4_TINY)
+            {
+                AERROR << "Unsupported net type on the cpu: " << config_.net_type;
+                return false;
+            }
+            std::unique_ptr<Impl> impl(new Impl);
+
+            // find the yolo layers in the cfg
+            std::vector<CfgBlock> blocks = ParseCfg(config_.file_model_cfg);
+            if (blocks.empty() || blocks[0]["type"] != "net")
+            {
+                AERROR << "Cannot read the network cfg: " << config_.file_model_cfg;
+                return false;
+            }
+            impl->input_w = std::stoul(blocks[0]["width"]);
+            impl->input_h = std::stoul(blocks[0]["height"]);
+            for (size_t k = 1; k < blocks.size(); ++k)
+            {
+                if (blocks[k]["type"] != "yolo")
+                {
+                    continue;
+                }
+                if (blocks[k - 1]["type"] != "convolutional")
+                {
+                    AERROR << "The yolo layer " << k - 1 << " does not follow a convolution";
+                    return false;
+                }
+                TensorInfo tensor;
+                // the darknet importer of OpenCV names the layers by their index, without the [net] section
+                tensor.blobName = "conv_" + std::to_string(k - 2);
+                tensor.anchors = ParseList<float>(blocks[k]["anchors"], [](const std::string &s) { return std::stof(s); });
+                tensor.masks = ParseList<uint32_t>(blocks[k]["mask"], [](const std::string &s) { return static_cast<uint32_t>(std::stoul(s)); });
+                tensor.numBBoxes = tensor.masks.size();
+                tensor.numClasses = std::stoul(blocks[k]["classes"]);
+                impl->output_names.push_back(tensor.blobName);
+                impl->tensors.push_back(tensor);
+            }
+            if (impl->tensors.empty())
+            {
+                AERROR << "No yolo layer in the network cfg: " << config_.file_model_cfg;
+                return false;
+            }
+
+            // load the network
+            try
+            {
+                impl->net = cv::dnn::readNetFromDarknet(config_.file_model_cfg, config_.file_model_weights);
+            }
+            catch (const cv::Exception &e)
+            {
+                AERROR << "Cannot load the darknet network: " << e.what();
+                return false;
+            }
+            impl->net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+            impl->net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+            for (const auto &name : impl->output_names)
+            {
+                if (impl->net.getLayerId(name) < 0)
+                {
+                    AERROR << "Cannot find the layer " << name << " in the darknet network";
+                    return false;
+                }
+            }
+
+            // run once on a blank input to get the grid of each yolo layer, and to allocate the buffers
+            const int input_shape[] = {1, 3, static_cast<int>(impl->input_h), static_cast<int>(impl->input_w)};
+            impl->blob = cv::Mat(4, input_shape, CV_32F, cv::Scalar(0));
+            impl->net.setInput(impl->blob);
+            impl->net.forward(impl->outputs, impl->output_names);
+            for (size_t i = 0; i < impl->tensors.size(); ++i)
+            {
+                TensorInfo &tensor = impl->tensors[i];
+                const cv::Mat &output = impl->outputs[i];
+                if (output.dims != 4 || static_cast<uint32_t>(output.size[1]) != tensor.numBBoxes * (5 + tensor.numClasses))
+                {
+                    AERROR << "Unexpected output shape of the layer " << tensor.blobName;
+                    return false;
+                }
+                tensor.grid_h = output.size[2];
+                tensor.grid_w = output.size[3];
+                tensor.gridSize = tensor.grid_h;
+                tensor.stride_h = impl->input_h / tensor.grid_h;
+                tensor.stride_w = impl->input_w / tensor.grid_w;
+                tensor.stride = tensor.stride_w;
+                tensor.volume = output.total();
+            }
+
+            // the same post-processing as the TensorRT detector
+            impl->decoder.setProbThresh(config_.detect_thresh);
+            impl->decoder.setClassWhitelist(std::vector<uint32_t>(config_.class_whitelist.begin(),
+                                                                  config_.class_whitelist.end()));
+            impl->nms.setTopK(std::max(0, config_.nms_top_k));
+            impl->nms_type = (config_.net_type == YOLOV4 || config_.net_type == YOLOV4_TINY) ? NmsType::kDIoU : NmsType::kIoU;
+            impl->proposals.reserve(YoloDecoder::maxProposals(impl->tensors));
+
+            impl_ = std::move(impl);
+            return true;
+        }
+
+        bool YoloCpuObjectDetector::Detect(const cv::Mat &frame,
+                                           std::vector<ObjectDetectionResult> &results)
+        {
+            if (!impl_)
+            {
+                AERROR << "The cpu detector is not initialized";
+                return false;
+            }
+            // the network takes rgb in [0, 1], the TensorRT one does the division itself
+            cv::dnn::blobFromImage(frame, impl_->blob, 1.0 / 255.0,
+                                   cv::Size(impl_->input_w, impl_->input_h), cv::Scalar(), true, false, CV_32F);
+            impl_->net.setInput(impl_->blob);
+            impl_->net.forward(impl_->outputs, impl_->output_names);
+
+            // post-process
+            impl_->proposals.clear();
+            for (size_t i = 0; i < impl_->tensors.size(); ++i)
+            {
+                float *output = impl_->outputs[i].ptr<float>();
+                Activate(output, impl_->tensors[i], impl_->decoder.getProbThresh());
+                impl_->decoder.decode(output, impl_->tensors[i], impl_->input_w, impl_->input_h,
+                                      frame.cols, frame.rows, impl_->proposals);
+            }
+            impl_->nms.run(impl_->proposals, impl_->nms_thresh, impl_->nms_type, impl_->detections);
+            for (const auto &b : impl_->detections)
+            {
+                const int x = b.box.x1;
+                const int y = b.box.y1;
+                const int w = b.box.x2 - b.box.x1;
+                const int h = b.box.y2 - b.box.y1;
+                const cv::Rect rect(x, y, w, h);
+                bool is_width_valid = rect.width <= config_.max_width &&
+                                      rect.width >= config_.min_width;
+                bool is_height_valid = rect.height <= config_.max_height &&
+                                       rect.height >= config_.min_height;
+                if (is_width_valid && is_height_valid)
+                {
+                    results.emplace_back(rect, b.label, b.prob);
+                }
+            }
+            return true;
+        }
+
+        void YoloCpuObjectDetector::SetProbThresh(float m_prob_thresh)
+        {
+            config_.detect_thresh = m_prob_thresh;
+            if (impl_)
+            {
+                impl_->decoder.setProbThresh(m_prob_thresh);
+            }
+        }
+
+        void YoloCpuObjectDetector::SetWidthLimitation(float min_value, float max_value)
+        {
+            config_.min_width = min_value;
+            config_.max_width = max_value;
+        }
+
+        void YoloCpuObjectDetector::SetHeightLimitation(float min_value, float max_value)
+        {
+            config_.min_height = min_value;
+            config_.max_height = max_value;
+        }
+
+    } // namespace detector
+} // namespace ptl
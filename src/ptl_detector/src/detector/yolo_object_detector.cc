@@ -1,10 +1,6 @@
 #include "ptl_detector/detector/yolo_object_detector.h"
 
-#include <ros/package.h>
-
-#include <string>
-
-#include "ptl_detector/util/ros_util.h"
+#include "ptl_detector/util/log.h"
 
 namespace ptl
 {
@@ -13,68 +9,18 @@ namespace ptl
 
         bool YoloObjectDetector::Init()
         {
-            // get params
-            auto nh_ = RosNodeHandler::Instance()->GetNh();
-            XmlRpc::XmlRpcValue params;
-            GPARAM("/ptl_detector/object_detector", params);
-            std::string package_path = ros::package::getPath("ptl_detector");
-
-            auto net_type = static_cast<std::string>(params["net_type"]);
-            if (net_type == "YOLOV4")
-            {
-                config_.net_type = YOLOV4;
-            }
-            else if (net_type == "YOLOV4_TINY")
-            {
-                config_.net_type = YOLOV4_TINY;
-            }
-            else
-            {
-                AERROR << "Unsupported net type: " << net_type;
-                return false;
-            }
-            auto precision = static_cast<std::string>(params["inference_precision"]);
-            if (precision == "FP32")
-            {
-                config_.inference_precison = FP32;
-            }
-            else if (precision == "FP16")
-            {
-                config_.inference_precison = FP16;
-            }
-            else if (precision == "INT8")
-            {
-                config_.inference_precison = INT8;
-                config_.calibration_image_list_file_txt =
-                    package_path +
-                    static_cast<std::string>(params["calibration_image_list_file_txt"]);
-            }
-            else
+            if (!LoadConfig(config_))
             {
-                AERROR << "Unsupported inference precision: " << precision;
                 return false;
             }
 
-            config_.file_model_cfg =
-                package_path + static_cast<std::string>(params["model_cfg"]);
-            config_.file_model_weights =
-                package_path + static_cast<std::string>(params["model_weights"]);
-            config_.gpu_id = static_cast<int>(params["gpu_id"]);
-            config_.n_max_batch = static_cast<int>(params["n_max_batch"]);
-            config_.detect_thresh =
-                static_cast<float>(static_cast<double>(params["detect_thresh"]));
-            config_.min_width =
-                static_cast<float>(static_cast<int>(params["min_width"]));
-            config_.max_width =
-                static_cast<float>(static_cast<int>(params["max_width"]));
-            config_.min_height =
-                static_cast<float>(static_cast<int>(params["min_height"]));
-            config_.max_height =
-                static_cast<float>(static_cast<int>(params["max_height"]));
-
             // init detector
             detector_ = std::make_shared<Detector>();
-            detector_->init(config_);
+            if (!detector_->init(config_))
+            {
+                AERROR << "Cannot init the tensorrt detector";
+                return false;
+            }
 
             return true;
         }
@@ -85,7 +31,11 @@ namespace ptl
             config_ = config;
             // init detector
             detector_ = std::make_shared<Detector>();
-            detector_->init(config_);
+            if (!detector_->init(config_))
+            {
+                AERROR << "Cannot init the tensorrt detector";
+                return false;
+            }
             return true;
         }
 
@@ -94,14 +44,15 @@ namespace ptl
         {
             // FIXME note that the frame should be RGB order instead of BGR
             // construct inputs
-            std::vector<cv::Mat> batch_frames;
-            std::vector<BatchResult> batch_results_raw;
-            batch_frames.push_back(frame);
+            batch_frames_.assign(1, frame);
             // detect
-            detector_->detect(batch_frames, batch_results_raw);
+            if (!detector_->detect(batch_frames_, batch_results_raw_))
+            {
+                return false;
+            }
             // post-process
-            FilterResults(batch_results_raw[0]);
-            for (const auto &res : batch_results_raw[0])
+            FilterResults(batch_results_raw_[0]);
+            for (const auto &res : batch_results_raw_[0])
             {
                 results.emplace_back(res.rect, res.id, res.prob);
             }
@@ -112,19 +63,22 @@ namespace ptl
             const std::vector<cv::Mat> &batch_frames,
             std::vector<std::vector<ObjectDetectionResult>> &batch_results)
         {
-            // detect
-            std::vector<BatchResult> batch_results_raw;
-            detector_->detect(batch_frames, batch_results_raw);
-            // post-process
-            for (auto &batch_result_raw : batch_results_raw)
+            // detect, the raw results keep their capacity between batches
+            if (!detector_->detect(batch_frames, batch_results_raw_))
+            {
+                return false;
+            }
+            // post-process, straight into the results of the caller
+            for (auto &batch_result_raw : batch_results_raw_)
             {
                 FilterResults(batch_result_raw);
-                std::vector<ObjectDetectionResult> batch_result;
+                batch_results.emplace_back();
+                std::vector<ObjectDetectionResult> &batch_result = batch_results.back();
+                batch_result.reserve(batch_result_raw.size());
                 for (const auto &result : batch_result_raw)
                 {
                     batch_result.emplace_back(result.rect, result.id, result.prob);
                 }
-                batch_results.push_back(batch_result);
             }
             return true;
         }
@@ -0,0 +1,90 @@
+#include "ptl_detector/detector/yolo_object_detector.h"
+
+#include <ros/package.h>
+
+#include <string>
+
+#include "ptl_detector/util/ros_util.h"
+
+namespace ptl
+{
+    namespace detector
+    {
+
+        // apart from yolo_object_detector.cc, since the cpu detector shares it in the builds without TensorRT
+        bool YoloObjectDetector::LoadConfig(Config &config)
+        {
+            // get params
+            auto nh_ = RosNodeHandler::Instance()->GetNh();
+            XmlRpc::XmlRpcValue params;
+            GPARAM("/ptl_detector/object_detector", params);
+            std::string package_path = ros::package::getPath("ptl_detector");
+
+            auto net_type = static_cast<std::string>(params["net_type"]);
+            if (net_type == "YOLOV4")
+            {
+                config.net_type = YOLOV4;
+            }
+            else if (net_type == "YOLOV4_TINY")
+            {
+                config.net_type = YOLOV4_TINY;
+            }
+            else
+            {
+                AERROR << "Unsupported net type: " << net_type;
+                return false;
+            }
+            auto precision = static_cast<std::string>(params["inference_precision"]);
+            if (precision == "FP32")
+            {
+                config.inference_precison = FP32;
+            }
+            else if (precision == "FP16")
+            {
+                config.inference_precison = FP16;
+            }
+            else if (precision == "INT8")
+            {
+                config.inference_precison = INT8;
+                config.calibration_image_list_file_txt =
+                    package_path +
+                    static_cast<std::string>(params["calibration_image_list_file_txt"]);
+            }
+            else
+            {
+                AERROR << "Unsupported inference precision: " << precision;
+                return false;
+            }
+
+            config.file_model_cfg =
+                package_path + static_cast<std::string>(params["model_cfg"]);
+            config.file_model_weights =
+                package_path + static_cast<std::string>(params["model_weights"]);
+            config.gpu_id = static_cast<int>(params["gpu_id"]);
+            config.n_max_batch = static_cast<int>(params["n_max_batch"]);
+            config.detect_thresh =
+                static_cast<float>(static_cast<double>(params["detect_thresh"]));
+            config.min_width =
+                static_cast<float>(static_cast<int>(params["min_width"]));
+            config.max_width =
+                static_cast<float>(static_cast<int>(params["max_width"]));
+            config.min_height =
+                static_cast<float>(static_cast<int>(params["min_height"]));
+            config.max_height =
+                static_cast<float>(static_cast<int>(params["max_height"]));
+            if (params.hasMember("class_whitelist"))
+            {
+                for (int i = 0; i < params["class_whitelist"].size(); ++i)
+                {
+                    config.class_whitelist.push_back(static_cast<int>(params["class_whitelist"][i]));
+                }
+            }
+            if (params.hasMember("nms_top_k"))
+            {
+                config.nms_top_k = static_cast<int>(params["nms_top_k"]);
+            }
+            return true;
+        }
+
+    } // namespace detector
+} // namespace ptl
@@ -3,6 +3,16 @@ int main(int argc, char **argv)
 {
     ros::init(argc, argv, "ptl_node");
     ros::NodeHandle n("~");
-    ptl::node::Node ptl_node(n);
-    ros::spin();
+    try
+    {
+        ptl::node::Node ptl_node(n);
+        ros::spin();
+    }
+    catch (const std::exception &e)
+    {
+        //the detector can not run, stop the node
+        ROS_FATAL("%s", e.what());
+        return 1;
+    }
+    return 0;
 }
\ No newline at end of file
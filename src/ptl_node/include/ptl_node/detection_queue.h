@@ -0,0 +1,65 @@
+#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+
+#include <opencv2/core.hpp>
+#include <ros/time.h>
+
+namespace ptl
+{
+    namespace node
+    {
+        // what to drop when a frame comes to a full queue
+        enum class DropPolicy
+        {
+            kDropOldest, // the oldest waiting frame, so the worker always gets the latest one
+            kSkip        // the new frame, so the waiting frames keep their turn
+        };
+
+        bool drop_policy_from_string(const std::string &name, DropPolicy &policy);
+
+        struct DetectionJob
+        {
+            cv::Mat image;
+            ros::Time stamp;                                  // stamp of the camera frame
+            std::chrono::steady_clock::time_point push_time;  // when the frame went into the queue
+        };
+
+        struct DetectionQueueStats
+        {
+            size_t depth = 0;      // frames waiting
+            long int push_num = 0; // frames pushed
+            long int drop_num = 0; // frames dropped because the queue was full
+        };
+
+        // bounded queue of the frames to detect, between the camera callback and the detection worker
+        class DetectionQueue
+        {
+        public:
+            void init(const size_t capacity, const DropPolicy policy);
+
+            //push a frame and wake up the worker, return false if a frame is dropped
+            bool push(DetectionJob job);
+
+            //wait at most timeout for a frame, return false if there is none or the queue is closed
+            bool pop(DetectionJob &job, const std::chrono::milliseconds &timeout);
+
+            //wake up the worker to let it quit
+            void close();
+
+            DetectionQueueStats stats() const;
+
+        private:
+            mutable std::mutex mtx_;
+            std::condition_variable cv_;
+            std::deque<DetectionJob> jobs_;
+            size_t capacity_ = 1;
+            DropPolicy policy_ = DropPolicy::kDropOldest;
+            bool is_closed_ = false;
+            DetectionQueueStats stats_;
+        };
+    } // namespace node
+} // namespace ptl
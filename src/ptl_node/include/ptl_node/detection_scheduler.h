@@ -0,0 +1,84 @@
+#pragma once
+#include <string>
+
+#include "ptl_tracker/tracker_health.h"
+
+namespace ptl
+{
+    namespace node
+    {
+        struct DetectionSchedulerParam
+        {
+            int detect_every_k_frame = 5;        // detection interval at the start, and whenever there is no tracking object
+            bool enable_adaptive_cadence = true; // adapt the interval to the health of the tracking objects and the detector latency
+            int min_detect_interval = 1;         // bounds of the adaptive interval (in frames)
+            int max_detect_interval = 15;
+            int min_healthy_keypoint_num = 20;   // an object tracked with fewer keypoints is weak
+            bool enable_motion_gate = false;     // skip or trigger the detections by the motion ratio of the frames
+            double still_motion_ratio = 0.01;    // nothing moves if the ratio of the moving blocks is below this
+            double sudden_motion_ratio = 0.2;    // detect at once when the ratio of the moving blocks jumps above this
+            int timeout_margin_tick = 10;        // the result of a detection should land this many ticks before a tracking object times out
+            int max_skip_num = 10;               // detect anyway after skipping this many detections in a row
+        };
+
+        enum class DetectionReason
+        {
+            kNone,          // wait for the next detection
+            kCadence,       // the interval has passed
+            kDeadline,      // a tracking object would time out before the result of a later detection lands
+            kSuddenMotion,  // a sudden change of the frame
+            kSkippedStill   // the detection is skipped because nothing moves
+        };
+
+        struct DetectionSchedulerStats
+        {
+            long int detection_num = 0;
+            long int skip_num = 0;        // detections skipped because nothing moves
+            long int trigger_num = 0;     // detections triggered before their turn by a sudden change
+            long int deadline_num = 0;    // detections started before their turn by the timeout of a tracking object
+            long int speed_up_num = 0;    // intervals shortened because some tracking object is weak
+            long int back_off_num = 0;    // intervals lengthened because all the tracking objects are healthy
+            int interval = 0;             // the current detection interval (in frames)
+            double latency_frame = 0;     // the latency of the detection and the real-time reid (in frames)
+            DetectionReason last_reason = DetectionReason::kNone;
+        };
+
+        std::string to_string(const DetectionReason reason);
+
+        // decide on each frame whether to run the detector and the real-time reid
+        // the interval starts at detect_every_k_frame; with the adaptive cadence, it is halved after a detection while some tracking
+        // object is weak (failing, overlapping, or with few keypoints), and grows by one frame while all of them are healthy;
+        // whatever the interval, a detection starts early when a tracking object would time out before a later result lands
+        // with motion gating, a due detection is skipped when nothing moves and no tracking object is close to a timeout,
+        // and a sudden change triggers a detection at once
+        class DetectionScheduler
+        {
+        public:
+            DetectionScheduler() = default;
+            DetectionScheduler(const DetectionSchedulerParam &param)
+                : param_(param), frame_since_detection_(param.detect_every_k_frame), interval_(param.detect_every_k_frame)
+            {
+                stats_.interval = interval_;
+            }
+
+            //frame_time: stamp of the frame (in seconds), motion_ratio: ratio of the moving blocks of this frame,
+            //detection_latency: the last measured time of a detection and real-time reid cycle (in seconds)
+            bool should_detect(const double frame_time, const double motion_ratio, const tracker::TrackerHealth &health,
+                               const double detection_latency);
+
+            const DetectionSchedulerStats &stats() const { return stats_; }
+
+        private:
+            void adapt_interval(const tracker::TrackerHealth &health, const DetectionReason reason);
+
+            DetectionSchedulerParam param_;
+            DetectionSchedulerStats stats_;
+            int frame_since_detection_ = 0; // counting this frame
+            int interval_ = 0;
+            int skip_in_row_ = 0;
+            bool is_sudden_pre_ = false;    // whether the previous frame was already a sudden change
+            double frame_time_pre_ = 0;
+            double frame_period_ = 0;       // smoothed time between two frames
+        };
+    } // namespace node
+} // namespace ptl
@@ -1,6 +1,13 @@
 #pragma once
+#include <atomic>
+#include <functional>
+#include <memory>
+#include <thread>
+
 #include "ptl_tracker/tracker.h"
 #include "ptl_reid_cpp/reid.h"
+#include "ptl_node/detection_scheduler.h"
+#include "ptl_node/detection_queue.h"
 
 namespace ptl
 {
@@ -8,7 +15,9 @@ namespace ptl
     {
         struct NodeParam
         {
-            int detect_every_k_frame = 5;
+            DetectionSchedulerParam scheduler_param;
+            int detection_queue_size = 1;                     // frames waiting for the detection worker
+            std::string detection_drop_policy = "drop_oldest"; // "drop_oldest" or "skip", what to drop when the queue is full
             std::string lidar_topic = "/rslidar_points";
             std::string camera_topic = "/camera2/color/image_raw/compressed";
             int min_offline_query_data_size = 10;
@@ -19,6 +28,7 @@ namespace ptl
         public:
             Node() = default;
             Node(const ros::NodeHandle &n);
+            ~Node();
 
             // //load config, init ptl_reid, register two callback function with the subscriber
             // void init();
@@ -30,6 +40,12 @@ namespace ptl
 
             void lidar_callback(const sensor_msgs::PointCloud2ConstPtr &point_cloud);
 
+            //called on the tracker thread, push the dead tracking objects with enough data to the offline reid
+            void push_dead_objects(const std::vector<tracker::LocalObject> &dead_object);
+
+            //the detection worker: take the frames from the detection queue, and run the real-time reid on them one by one
+            void detection_loop();
+
             void reid_real_time(const cv::Mat &image, const ros::Time &time_now);
 
             ros::NodeHandle nh_;
@@ -39,8 +55,12 @@ namespace ptl
 
             ros::Subscriber lidar_sub, camera_sub;
 
-            std::thread *reid_real_time_thread = nullptr;
-            long int frame_count = 0;
+            DetectionScheduler detection_scheduler;
+            DetectionQueue detection_queue;
+            std::thread detection_worker;
+            std::atomic<bool> is_shutdown{false};
+            std::atomic<double> detection_latency{0}; // time from queuing a frame to posting its detections to the tracker (in seconds)
+            std::atomic<double> detection_age{0};     // age of the last frame when its detections are posted to the tracker (in seconds)
         };
     } // namespace node
 } // namespace ptl
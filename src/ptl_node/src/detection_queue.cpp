@@ -0,0 +1,86 @@
+#include <algorithm>
+
+#include "ptl_node/detection_queue.h"
+
+namespace ptl
+{
+    namespace node
+    {
+        bool drop_policy_from_string(const std::string &name, DropPolicy &policy)
+        {
+            if (name == "drop_oldest")
+            {
+                policy = DropPolicy::kDropOldest;
+                return true;
+            }
+            if (name == "skip")
+            {
+                policy = DropPolicy::kSkip;
+                return true;
+            }
+            return false;
+        }
+
+        void DetectionQueue::init(const size_t capacity, const DropPolicy policy)
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            capacity_ = std::max<size_t>(1, capacity);
+            policy_ = policy;
+            is_closed_ = false;
+            jobs_.clear();
+            stats_ = DetectionQueueStats();
+        }
+
+        bool DetectionQueue::push(DetectionJob job)
+        {
+            bool is_dropped = false;
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                stats_.push_num++;
+                if (jobs_.size() >= capacity_)
+                {
+                    is_dropped = true;
+                    stats_.drop_num++;
+                    if (policy_ == DropPolicy::kSkip)
+                    {
+                        return false;
+                    }
+                    jobs_.pop_front();
+                }
+                jobs_.push_back(std::move(job));
+                stats_.depth = jobs_.size();
+            }
+            cv_.notify_one();
+            return !is_dropped;
+        }
+
+        bool DetectionQueue::pop(DetectionJob &job, const std::chrono::milliseconds &timeout)
+        {
+            std::unique_lock<std::mutex> lk(mtx_);
+            cv_.wait_for(lk, timeout, [this] { return is_closed_ || !jobs_.empty(); });
+            if (is_closed_ || jobs_.empty())
+            {
+                return false;
+            }
+            job = std::move(jobs_.front());
+            jobs_.pop_front();
+            stats_.depth = jobs_.size();
+            return true;
+        }
+
+        void DetectionQueue::close()
+        {
+            {
+                std::lock_guard<std::mutex> lk(mtx_);
+                is_closed_ = true;
+            }
+            cv_.notify_all();
+        }
+
+        DetectionQueueStats DetectionQueue::stats() const
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            return stats_;
+        }
+    } // namespace node
+} // namespace ptl
@@ -0,0 +1,119 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ptl_node/detection_scheduler.h"
+
+namespace ptl
+{
+    namespace node
+    {
+        std::string to_string(const DetectionReason reason)
+        {
+            switch (reason)
+            {
+            case DetectionReason::kCadence:
+                return "cadence";
+            case DetectionReason::kDeadline:
+                return "deadline";
+            case DetectionReason::kSuddenMotion:
+                return "sudden motion";
+            case DetectionReason::kSkippedStill:
+                return "skipped still";
+            default:
+                return "none";
+            }
+        }
+
+        bool DetectionScheduler::should_detect(const double frame_time, const double motion_ratio, const tracker::TrackerHealth &health,
+                                               const double detection_latency)
+        {
+            //measure the frame rate to count the detection latency in frames
+            if (frame_time_pre_ > 0 && frame_time > frame_time_pre_)
+            {
+                const double period = frame_time - frame_time_pre_;
+                frame_period_ = frame_period_ > 0 ? 0.9 * frame_period_ + 0.1 * period : period;
+            }
+            frame_time_pre_ = frame_time;
+            stats_.latency_frame = frame_period_ > 0 ? detection_latency / frame_period_ : 0;
+
+            DetectionReason reason = DetectionReason::kNone;
+            if (frame_since_detection_ >= interval_)
+            {
+                reason = DetectionReason::kCadence;
+            }
+            //a detection started on the next frame lands latency_frame + 1 ticks later, start now if that is too close to a timeout,
+            //but not before the result of the previous detection is back
+            else if (param_.enable_adaptive_cadence && health.track_num > 0 &&
+                     health.min_ticks_to_timeout - 1 - stats_.latency_frame <= param_.timeout_margin_tick &&
+                     frame_since_detection_ >= std::max(param_.min_detect_interval, static_cast<int>(std::ceil(stats_.latency_frame))))
+            {
+                reason = DetectionReason::kDeadline;
+            }
+
+            if (param_.enable_motion_gate)
+            {
+                //only the frame where the change starts triggers, a long change (e.g. the camera moves) goes with the cadence
+                const bool is_sudden = motion_ratio >= param_.sudden_motion_ratio;
+                if (reason == DetectionReason::kNone && is_sudden && !is_sudden_pre_)
+                {
+                    reason = DetectionReason::kSuddenMotion;
+                }
+                else if (reason == DetectionReason::kCadence && motion_ratio < param_.still_motion_ratio &&
+                         health.min_ticks_to_timeout > param_.timeout_margin_tick && skip_in_row_ < param_.max_skip_num)
+                {
+                    reason = DetectionReason::kSkippedStill;
+                }
+                is_sudden_pre_ = is_sudden;
+            }
+            stats_.last_reason = reason;
+
+            if (reason == DetectionReason::kNone)
+            {
+                frame_since_detection_++;
+                return false;
+            }
+            if (reason == DetectionReason::kSkippedStill)
+            {
+                //a skipped detection takes its turn, the next one is an interval later
+                frame_since_detection_ = 1;
+                skip_in_row_++;
+                stats_.skip_num++;
+                return false;
+            }
+
+            stats_.deadline_num += reason == DetectionReason::kDeadline;
+            stats_.trigger_num += reason == DetectionReason::kSuddenMotion;
+            stats_.detection_num++;
+            frame_since_detection_ = 1;
+            skip_in_row_ = 0;
+            adapt_interval(health, reason);
+            return true;
+        }
+
+        void DetectionScheduler::adapt_interval(const tracker::TrackerHealth &health, const DetectionReason reason)
+        {
+            if (!param_.enable_adaptive_cadence)
+            {
+                stats_.interval = interval_;
+                return;
+            }
+            if (health.track_num == 0)
+            {
+                //nothing to keep, only look for the new objects
+                interval_ = param_.detect_every_k_frame;
+            }
+            else if (health.failing_num > 0 || health.overlap_num > 0 || health.min_keypoint_num < param_.min_healthy_keypoint_num)
+            {
+                interval_ = std::max(param_.min_detect_interval, interval_ / 2);
+                stats_.speed_up_num++;
+            }
+            else if (reason != DetectionReason::kDeadline)
+            {
+                //the deadline already limits the interval, growing it would not detect less
+                interval_ = std::min(param_.max_detect_interval, interval_ + 1);
+                stats_.back_off_num++;
+            }
+            stats_.interval = interval_;
+        }
+    } // namespace node
+} // namespace ptl
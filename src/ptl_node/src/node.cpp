@@ -13,17 +13,48 @@ namespace ptl
         Node::Node(const ros::NodeHandle &n) : nh_(n), ptl_reid(n), ptl_tracker(n)
         {
             load_config();
+            detection_scheduler = DetectionScheduler(node_param.scheduler_param);
+            DropPolicy drop_policy = DropPolicy::kDropOldest;
+            if (!drop_policy_from_string(node_param.detection_drop_policy, drop_policy))
+            {
+                ROS_ERROR_STREAM("Unknown detection drop policy " << node_param.detection_drop_policy << ", use drop_oldest instead.");
+            }
+            detection_queue.init(node_param.detection_queue_size, drop_policy);
             ptl_reid.init();
+            ptl_tracker.set_dead_object_callback(std::bind(&Node::push_dead_objects, this, std::placeholders::_1));
             ptl_tracker.init();
+            //a single worker runs the detections, so the real-time reid never races with itself on the detector and the tracker
+            detection_worker = std::thread(&Node::detection_loop, this);
             lidar_sub = nh_.subscribe(node_param.lidar_topic, 1, &Node::lidar_callback, this);
             camera_sub = nh_.subscribe(node_param.camera_topic, 1, &Node::camera_callback, this);
         }
 
+        Node::~Node()
+        {
+            is_shutdown = true;
+            detection_queue.close();
+            if (detection_worker.joinable())
+            {
+                detection_worker.join();
+            }
+        }
+
         void Node::load_config()
         {
             GPARAM(nh_, "/node/lidar_topic", node_param.lidar_topic);
             GPARAM(nh_, "/node/camera_topic", node_param.camera_topic);
-            GPARAM(nh_, "/node/detect_every_k_frame", node_param.detect_every_k_frame);
+            GPARAM(nh_, "/node/detect_every_k_frame", node_param.scheduler_param.detect_every_k_frame);
+            GPARAM(nh_, "/node/enable_adaptive_cadence", node_param.scheduler_param.enable_adaptive_cadence);
+            GPARAM(nh_, "/node/min_detect_interval", node_param.scheduler_param.min_detect_interval);
+            GPARAM(nh_, "/node/max_detect_interval", node_param.scheduler_param.max_detect_interval);
+            GPARAM(nh_, "/node/min_healthy_keypoint_num", node_param.scheduler_param.min_healthy_keypoint_num);
+            GPARAM(nh_, "/node/enable_motion_gate", node_param.scheduler_param.enable_motion_gate);
+            GPARAM(nh_, "/node/still_motion_ratio", node_param.scheduler_param.still_motion_ratio);
+            GPARAM(nh_, "/node/sudden_motion_ratio", node_param.scheduler_param.sudden_motion_ratio);
+            GPARAM(nh_, "/node/timeout_margin_tick", node_param.scheduler_param.timeout_margin_tick);
+            GPARAM(nh_, "/node/max_skip_num", node_param.scheduler_param.max_skip_num);
+            GPARAM(nh_, "/node/detection_queue_size", node_param.detection_queue_size);
+            GPARAM(nh_, "/node/detection_drop_policy", node_param.detection_drop_policy);
             GPARAM(nh_, "/node/min_offline_query_data_size", node_param.min_offline_query_data_size);
         }
 
@@ -34,29 +65,39 @@ namespace ptl
             cv_bridge::CvImagePtr cv_ptr;
             cv_ptr = cv_bridge::toCvCopy(image, sensor_msgs::image_encodings::BGR8);
 
-            //create a real-time reid thread for every k frames to detect objects in the image
-            if (frame_count % node_param.detect_every_k_frame == 0)
-            {
-                ROS_INFO("Create real-time reid thread!");
-                reid_real_time_thread = new std::thread(&Node::reid_real_time, this, cv_ptr->image, cv_ptr->header.stamp);
-            }
-            frame_count++;
-
-            // track by optical flow tracker
-            std::vector<tracker::LocalObject> dead_object = ptl_tracker.update_bbox_by_tracker(cv_ptr->image, cv_ptr->header.stamp);
+            // track by optical flow tracker, which also measures the motion of the frame, on the tracker thread
+            ptl_tracker.push_frame(cv_ptr->image, cv_ptr->header.stamp);
 
-            // push dead object to the offlin reid buffer
-            if (!dead_object.empty())
+            //hand the image to the detection worker when the scheduler asks for a detection
+            //the snapshot may not include this frame yet, the timeout margin of the scheduler covers that
+            std::shared_ptr<const tracker::TrackerSnapshot> tracker_state = ptl_tracker.snapshot();
+            if (detection_scheduler.should_detect(cv_ptr->header.stamp.toSec(), tracker_state->motion_ratio, tracker_state->health,
+                                                  detection_latency))
             {
-                for (auto dio : dead_object)
+                DetectionJob job;
+                job.image = cv_ptr->image;
+                job.stamp = cv_ptr->header.stamp;
+                job.push_time = std::chrono::steady_clock::now();
+                if (!detection_queue.push(std::move(job)))
                 {
-                    if (dio.img_blocks.size() + dio.features_vector.size() / 2048 > node_param.min_offline_query_data_size) //TODO hardcode in here
-                    {
-                        std::lock_guard<std::mutex> lk(ptl_reid.mtx);
-                        ptl_reid.reid_offline_buffer.emplace_back(dio.example_image, dio.img_blocks, dio.position, dio.features_vector);
-                    }
+                    ROS_WARN("The detection worker is busy, drop a frame!");
                 }
             }
+            const DetectionQueueStats queue_stats = detection_queue.stats();
+            ROS_INFO_STREAM("Detection queue: depth " << queue_stats.depth << ", " << queue_stats.drop_num << "/" << queue_stats.push_num
+                                                      << " frames dropped, detection age " << detection_age * 1000 << " ms, latency "
+                                                      << detection_latency * 1000 << " ms.");
+            const DetectionSchedulerStats &scheduler_stats = detection_scheduler.stats();
+            ROS_INFO_STREAM("Detection scheduler: " << to_string(scheduler_stats.last_reason) << ", interval " << scheduler_stats.interval
+                                                    << " frames, latency " << scheduler_stats.latency_frame << " frames | "
+                                                    << scheduler_stats.detection_num << " detections (" << scheduler_stats.deadline_num
+                                                    << " by deadline, " << scheduler_stats.trigger_num << " by sudden motion), "
+                                                    << scheduler_stats.skip_num << " skipped, " << scheduler_stats.speed_up_num
+                                                    << " speed-ups, " << scheduler_stats.back_off_num << " back-offs.");
+            const tracker::TrackerCommandStats &command_stats = tracker_state->command_stats;
+            ROS_INFO_STREAM("Tracker commands: " << command_stats.frame_num << " frames, " << command_stats.detection_num << " detections, "
+                                                 << command_stats.lidar_num << " lidar scans applied, " << command_stats.pending_num
+                                                 << " pending, " << command_stats.drop_num << " dropped.");
             ROS_INFO_STREAM("Camera callback takes " << t.toc() * 1000 << " ms.");
             ROS_INFO("******Out of camera callback******");
             std::cout << std::endl;
@@ -64,25 +105,59 @@ namespace ptl
 
         void Node::lidar_callback(const sensor_msgs::PointCloud2ConstPtr &point_cloud)
         {
-            ptl_tracker.lidar_tracker_callback(point_cloud);
+            ptl_tracker.push_lidar(point_cloud);
+        }
+
+        void Node::push_dead_objects(const std::vector<tracker::LocalObject> &dead_object)
+        {
+            // push dead object to the offlin reid buffer
+            for (const auto &dio : dead_object)
+            {
+                if (dio.img_blocks.size() + dio.feature_reservoir.size() > node_param.min_offline_query_data_size)
+                {
+                    ptl_reid.push_offline(dio.example_image, dio.img_blocks, dio.position, dio.feature_reservoir.features(),
+                                          dio.bbox_last_update_time.toSec(), dio.img_blocks_occluded, dio.img_blocks_size);
+                }
+            }
+        }
+
+        void Node::detection_loop()
+        {
+            DetectionJob job;
+            while (!is_shutdown && ros::ok())
+            {
+                //wake up now and then to check the shutdown
+                if (!detection_queue.pop(job, std::chrono::milliseconds(100)))
+                {
+                    continue;
+                }
+                reid_real_time(job.image, job.stamp);
+                detection_latency = std::chrono::duration<double>(std::chrono::steady_clock::now() - job.push_time).count();
+                detection_age = (ros::Time::now() - job.stamp).toSec();
+                job.image.release();
+            }
         }
 
         void Node::reid_real_time(const cv::Mat &image, const ros::Time &time_now)
         {
             timer t;
             //do real time reid first
-            std::vector<cv::Rect2d> bboxes;
+            //the detected objects that match a tracking object may reuse its cached feature
+            std::vector<int> track_ids;
+            std::vector<cv::Rect2d> bboxes, track_bboxes;
             std::vector<float> feat;
-            ptl_reid.reid_realtime(image, bboxes, feat);
-            ROS_INFO_STREAM("(0x0): Real-time Reid takes " << t.toc() * 1000 << " ms.");
+            ptl_tracker.get_tracking_bboxes(track_ids, track_bboxes);
+            ptl_reid.reid_realtime(image, bboxes, feat, track_ids, track_bboxes);
+            ROS_INFO_STREAM("(0x0): Real-time Reid takes " << t.toc() * 1000 << " ms, embedding cache hit rate: "
+                                                           << ptl_reid.embedding_cache.hit_rate() << " ("
+                                                           << ptl_reid.embedding_cache.hit_num() << " hits, "
+                                                           << ptl_reid.embedding_cache.miss_num() << " misses).");
 
-            //then update the tracker
-            t.tic();
+            //then hand the detections to the tracker thread
             if (!feat.empty())
             {
-                ptl_tracker.update_bbox_by_detector(image, bboxes, feat, time_now);
+                ptl_tracker.push_detection(image, bboxes, feat, time_now);
             }
-            ROS_INFO_STREAM("(0x0): Update tracker takes " << t.toc() * 1000 << " ms.");
         }
     } // namespace node
 } // namespace ptl
@@ -0,0 +1,131 @@
+// compare the gallery indexes of the reid database (flat, inverted file and HNSW) on synthetic features
+// usage: gallery_index_benchmark [feat_dimension] [k] [gallery_size ...]
+// the features are clustered by identity like reid embeddings, the default gallery sizes are 10k, 100k and 1M features
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <numeric>
+#include <random>
+#include <set>
+
+#include <faiss/index_io.h>
+#include <faiss/impl/io.h>
+
+#include "ptl_reid_cpp/reid_database.h"
+
+using idx_t = faiss::Index::idx_t;
+
+// unit-length features of identities with feat_per_identity noisy views each
+void generate_features(const idx_t n, const int d, const int feat_per_identity, std::mt19937 &rng, std::vector<float> &feat)
+{
+    std::normal_distribution<float> normal(0, 1);
+    std::vector<float> center(d);
+    feat.resize(n * d);
+    for (idx_t i = 0; i < n; i++)
+    {
+        if (i % feat_per_identity == 0)
+        {
+            for (auto &c : center)
+            {
+                c = normal(rng);
+            }
+        }
+        float norm = 0;
+        for (int j = 0; j < d; j++)
+        {
+            feat[i * d + j] = center[j] + 0.5 * normal(rng);
+            norm += feat[i * d + j] * feat[i * d + j];
+        }
+        norm = std::sqrt(norm);
+        for (int j = 0; j < d; j++)
+        {
+            feat[i * d + j] /= norm;
+        }
+    }
+}
+
+double recall(const std::vector<idx_t> &index_gt, const std::vector<idx_t> &index, const idx_t query_num, const idx_t k)
+{
+    int hit = 0;
+    for (idx_t i = 0; i < query_num; i++)
+    {
+        std::set<idx_t> gt(index_gt.begin() + i * k, index_gt.begin() + (i + 1) * k);
+        for (idx_t j = i * k; j < (i + 1) * k; j++)
+        {
+            hit += gt.count(index[j]);
+        }
+    }
+    return 1.0 * hit / (query_num * k);
+}
+
+size_t index_memory(const faiss::Index &db)
+{
+    faiss::VectorIOWriter writer;
+    faiss::write_index(&db, &writer);
+    return writer.data.size();
+}
+
+int main(int argc, char *argv[])
+{
+    ptl::reid::DataBaseParam db_param;
+    db_param.feat_dimension = argc > 1 ? std::stoi(argv[1]) : 512;
+    const idx_t k = argc > 2 ? std::stoi(argv[2]) : 10;
+    std::vector<idx_t> gallery_size;
+    for (int i = 3; i < argc; i++)
+    {
+        gallery_size.push_back(std::stol(argv[i]));
+    }
+    if (gallery_size.empty())
+    {
+        gallery_size = {10000, 100000, 1000000};
+    }
+    const int d = db_param.feat_dimension;
+    const idx_t query_num = 200;
+    const int feat_per_identity = 20;
+
+    std::mt19937 rng(0);
+    for (auto n : gallery_size)
+    {
+        std::vector<float> feat, feat_query;
+        generate_features(n + query_num, d, feat_per_identity, rng, feat);
+        //take one view of some identities out as the queries
+        for (idx_t i = 0; i < query_num; i++)
+        {
+            idx_t row = (n / query_num) * i;
+            feat_query.insert(feat_query.end(), feat.begin() + row * d, feat.begin() + (row + 1) * d);
+            std::copy(feat.end() - (i + 1) * d, feat.end() - i * d, feat.begin() + row * d);
+        }
+        feat.resize(n * d);
+        std::vector<idx_t> label(n);
+        std::iota(label.begin(), label.end(), 0);
+        std::cout << "gallery: " << n << " | dimension: " << d << " | query: " << query_num << " | k: " << k << std::endl;
+
+        std::vector<float> distance_gt(query_num * k), distance(query_num * k);
+        std::vector<idx_t> index_gt(query_num * k), index(query_num * k);
+        auto t_start = std::chrono::steady_clock::now();
+        ptl::reid::brute_force_search(feat_query.data(), query_num, feat.data(), n, d, k, distance_gt.data(), index_gt.data());
+        double t_search = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+        std::cout << "flat | recall@" << k << ": 1 | memory: " << n * d * sizeof(float) / 1024 / 1024 << " MB"
+                  << " | build: 0 s | search: " << t_search * 1000 / query_num << " ms/query" << std::endl;
+
+        for (auto type : {"ivf", "hnsw"})
+        {
+            db_param.large_db_type = type;
+            t_start = std::chrono::steady_clock::now();
+            std::unique_ptr<faiss::Index> db = ptl::reid::build_large_db(feat, label, db_param);
+            double t_build = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+
+            t_start = std::chrono::steady_clock::now();
+            ptl::reid::search_large_db(*db, db_param, feat.data(), query_num, feat_query.data(), k, distance.data(), index.data());
+            t_search = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+
+            //the inverted file re-ranks with the raw features, which are kept by the database anyway
+            std::cout << (db_param.large_db_type == "ivf" ? "ivf (" + db_param.inverted_file_type + ")" : "hnsw")
+                      << " | recall@" << k << ": " << recall(index_gt, index, query_num, k)
+                      << " | memory: " << index_memory(*db) / 1024 / 1024 << " MB"
+                      << " | build: " << t_build << " s | search: " << t_search * 1000 / query_num << " ms/query" << std::endl;
+        }
+        std::cout << std::endl;
+    }
+    return 0;
+}
@@ -0,0 +1,90 @@
+// measure the recall@k of the inverted file types of the reid database against brute-force search
+// usage: inverted_file_recall <feature_file> [feat_dimension] [query_num] [k]
+// the feature file stores raw float32 features (e.g. embeddings recorded from the reid network), one feature after another
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <numeric>
+#include <set>
+
+#include "ptl_reid_cpp/reid_database.h"
+
+using idx_t = faiss::Index::idx_t;
+
+int main(int argc, char *argv[])
+{
+    if (argc < 2)
+    {
+        std::cout << "usage: inverted_file_recall <feature_file> [feat_dimension] [query_num] [k]" << std::endl;
+        return 1;
+    }
+    ptl::reid::DataBaseParam db_param;
+    db_param.feat_dimension = argc > 2 ? std::stoi(argv[2]) : 2048;
+    const idx_t query_num = argc > 3 ? std::stoi(argv[3]) : 100;
+    const idx_t k = argc > 4 ? std::stoi(argv[4]) : 10;
+    const int d = db_param.feat_dimension;
+
+    std::ifstream feature_file(argv[1], std::ios::binary | std::ios::ate);
+    if (!feature_file)
+    {
+        std::cout << "Cannot open the feature file: " << argv[1] << std::endl;
+        return 1;
+    }
+    std::vector<float> feat(feature_file.tellg() / sizeof(float));
+    feature_file.seekg(0);
+    feature_file.read(reinterpret_cast<char *>(feat.data()), feat.size() * sizeof(float));
+    const idx_t num_feat = feat.size() / d;
+    if (num_feat <= query_num)
+    {
+        std::cout << "Too few features in the feature file: " << num_feat << std::endl;
+        return 1;
+    }
+
+    // the last query_num features are used as queries, the others as the gallery
+    std::vector<float> feat_query(feat.end() - query_num * d, feat.end());
+    feat.resize((num_feat - query_num) * d);
+    const idx_t num_gallery = num_feat - query_num;
+    std::cout << "gallery: " << num_gallery << " | query: " << query_num << " | k: " << k << std::endl;
+
+    std::vector<float> distance_gt(query_num * k), distance(query_num * k);
+    std::vector<idx_t> index_gt(query_num * k), index(query_num * k);
+    ptl::reid::brute_force_search(feat_query.data(), query_num, feat.data(), num_gallery, d, k, distance_gt.data(), index_gt.data());
+    std::cout << "flat | memory: " << num_gallery * d * sizeof(float) / 1024 / 1024 << " MB" << std::endl;
+
+    std::vector<idx_t> label(num_gallery);
+    std::iota(label.begin(), label.end(), 0);
+
+    for (auto type : {"ivf_flat", "ivf_sq8", "ivf_pq"})
+    {
+        db_param.inverted_file_type = type;
+        auto t_start = std::chrono::steady_clock::now();
+        std::unique_ptr<faiss::IndexIVF> db = ptl::reid::build_inverted_file(feat, label, db_param);
+        double t_build = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+
+        for (int rerank_k : {0, 2 * int(k), 5 * int(k)})
+        {
+            if (rerank_k > 0 && db_param.inverted_file_type == "ivf_flat")
+            {
+                continue;
+            }
+            db_param.rerank_k = rerank_k;
+            t_start = std::chrono::steady_clock::now();
+            ptl::reid::search_inverted_file(*db, db_param, feat.data(), query_num, feat_query.data(), k, distance.data(), index.data());
+            double t_search = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_start).count();
+
+            int hit = 0;
+            for (idx_t i = 0; i < query_num; i++)
+            {
+                std::set<idx_t> gt(index_gt.begin() + i * k, index_gt.begin() + (i + 1) * k);
+                for (idx_t j = i * k; j < (i + 1) * k; j++)
+                {
+                    hit += gt.count(index[j]);
+                }
+            }
+            std::cout << type << " | rerank: " << rerank_k << " | recall@" << k << ": " << 1.0 * hit / (query_num * k)
+                      << " | code memory: " << db->ntotal * db->code_size / 1024 / 1024 << " MB"
+                      << " | build: " << t_build << " s | search: " << t_search * 1000 / query_num << " ms/query" << std::endl;
+        }
+    }
+    return 0;
+}
@@ -4,8 +4,17 @@ int main(int argc, char *argv[])
 {
     ros::init(argc, argv, "ptl_reid");
     ros::NodeHandle n("~");
-    ptl::reid::Reid reid(n);
-    reid.init();
-    ros::spin();
+    try
+    {
+        ptl::reid::Reid reid(n);
+        reid.init();
+        ros::spin();
+    }
+    catch (const std::exception &e)
+    {
+        //the detector can not run, stop the node
+        ROS_FATAL("%s", e.what());
+        return 1;
+    }
     return 0;
 }
@@ -0,0 +1,164 @@
+// replay an insert/query workload of synthetic tracks on the reid database, without ROS or TensorRT
+// usage: reid_database_benchmark [identity_num] [query_track_num] [feat_per_track] [noise] [large_db_type] [feat_dimension]
+// each identity is a random direction, a track is feat_per_track noisy views of one identity (like the features of a dead track)
+// the insert phase brings in every identity once, the query phase replays tracks of random identities that were seen before
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+#include <map>
+#include <random>
+#include <string>
+
+#include "ptl_reid_cpp/reid_database.h"
+
+// unit-length features of one track, the views of an identity are its center plus gaussian noise
+std::vector<float> generate_track(const std::vector<float> &center, const int feat_num, const float noise, std::mt19937 &rng)
+{
+    const int d = center.size();
+    std::normal_distribution<float> normal(0, 1);
+    std::vector<float> feat(feat_num * d);
+    for (int i = 0; i < feat_num; i++)
+    {
+        float norm = 0;
+        for (int j = 0; j < d; j++)
+        {
+            feat[i * d + j] = center[j] + noise * normal(rng);
+            norm += feat[i * d + j] * feat[i * d + j];
+        }
+        norm = std::sqrt(norm);
+        for (int j = 0; j < d; j++)
+        {
+            feat[i * d + j] /= norm;
+        }
+    }
+    return feat;
+}
+
+// resident and peak resident memory of this process in MB
+void memory_usage(double &rss, double &rss_peak)
+{
+    rss = rss_peak = 0;
+    std::ifstream status("/proc/self/status");
+    std::string key;
+    double value;
+    while (status >> key)
+    {
+        if (key == "VmRSS:" && status >> value)
+        {
+            rss = value / 1024;
+        }
+        else if (key == "VmHWM:" && status >> value)
+        {
+            rss_peak = value / 1024;
+        }
+    }
+}
+
+double percentile(std::vector<double> latency, const double p)
+{
+    if (latency.empty())
+    {
+        return 0;
+    }
+    std::sort(latency.begin(), latency.end());
+    return latency[std::min<size_t>(latency.size() - 1, p * latency.size())];
+}
+
+struct PhaseResult
+{
+    std::vector<double> latency;       // ms of each call
+    std::vector<double> rebuild_pause; // ms of the calls that started or swapped in a db_large
+    int correct = 0;
+    int false_merge = 0; // a new identity gets an old id, or an old identity gets the id of another one
+    int false_split = 0; // an old identity gets a new id
+};
+
+int main(int argc, char *argv[])
+{
+    const int identity_num = argc > 1 ? std::stoi(argv[1]) : 1000;
+    const int query_track_num = argc > 2 ? std::stoi(argv[2]) : 2000;
+    const int feat_per_track = argc > 3 ? std::stoi(argv[3]) : 8;
+    const float noise = argc > 4 ? std::stof(argv[4]) : 0.5;
+    ptl::reid::DataBaseParam db_param;
+    db_param.large_db_type = argc > 5 ? argv[5] : "ivf";
+    db_param.feat_dimension = argc > 6 ? std::stoi(argv[6]) : 2048;
+    const int d = db_param.feat_dimension;
+    std::cout << "identity: " << identity_num << " | query track: " << query_track_num << " | feature per track: " << feat_per_track
+              << " | noise: " << noise << " | large db: " << db_param.large_db_type << " | dimension: " << d << std::endl;
+
+    std::mt19937 rng(0);
+    std::normal_distribution<float> normal(0, 1);
+    std::vector<std::vector<float>> center(identity_num, std::vector<float>(d));
+    for (auto &c : center)
+    {
+        for (auto &x : c)
+        {
+            x = normal(rng);
+        }
+    }
+
+    ptl::reid::ReidDatabase db(db_param);
+    std::map<int, int> id_of_identity; // ground truth identity -> the id it got when it was first seen
+    auto run_track = [&](const int identity, PhaseResult &result) {
+        std::vector<float> feat = generate_track(center[identity], feat_per_track, noise, rng);
+        const int max_id_before = db.max_id;
+        const int build_num_before = db.db_large_build_num(), swap_num_before = db.db_large_swap_num();
+        auto t_start = std::chrono::steady_clock::now();
+        int id = db.query_and_update(feat, cv::Mat(), geometry_msgs::Point());
+        double t = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+        result.latency.push_back(t);
+        if (db.db_large_build_num() != build_num_before || db.db_large_swap_num() != swap_num_before)
+        {
+            result.rebuild_pause.push_back(t);
+        }
+
+        bool is_new_id = id >= max_id_before;
+        auto it = id_of_identity.find(identity);
+        if (it == id_of_identity.end())
+        {
+            result.correct += is_new_id;
+            result.false_merge += !is_new_id;
+            if (is_new_id)
+            {
+                id_of_identity[identity] = id;
+            }
+        }
+        else
+        {
+            result.correct += id == it->second;
+            result.false_split += is_new_id;
+            result.false_merge += !is_new_id && id != it->second;
+        }
+    };
+    auto report = [&](const std::string &phase, const PhaseResult &result) {
+        double rss, rss_peak;
+        memory_usage(rss, rss_peak);
+        double pause_max = result.rebuild_pause.empty() ? 0 : *std::max_element(result.rebuild_pause.begin(), result.rebuild_pause.end());
+        std::cout << phase << " | track: " << result.latency.size()
+                  << " | p50: " << percentile(result.latency, 0.5) << " ms | p99: " << percentile(result.latency, 0.99) << " ms"
+                  << " | rebuild pause: " << result.rebuild_pause.size() << " (max " << pause_max << " ms)"
+                  << " | id accuracy: " << 1.0 * result.correct / std::max<size_t>(1, result.latency.size())
+                  << " (false merge " << result.false_merge << ", false split " << result.false_split << ")"
+                  << " | rss: " << rss << " MB (peak " << rss_peak << " MB)" << std::endl;
+    };
+
+    //every identity is seen once, each track creates a new object
+    PhaseResult insert;
+    for (int i = 0; i < identity_num; i++)
+    {
+        run_track(i, insert);
+    }
+    report("insert", insert);
+
+    //the identities come back, each track is matched and adds its distinct features to the object
+    PhaseResult query;
+    std::uniform_int_distribution<int> pick(0, identity_num - 1);
+    for (int i = 0; i < query_track_num; i++)
+    {
+        run_track(pick(rng), query);
+    }
+    report("query", query);
+    return 0;
+}
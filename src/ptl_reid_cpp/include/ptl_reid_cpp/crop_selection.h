@@ -0,0 +1,29 @@
+#pragma once
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ptl
+{
+    namespace reid
+    {
+        struct CropSelectionParam
+        {
+            int max_crops_per_track = 16;     // crops inferred for a dead track at most, 0 to infer all of them
+            int min_crops_per_track = 4;      // crops inferred at least (if there are), however many real-time features the track has
+            float diversity_threshold = 4.0;  // min mean absolute difference (0-255) of the luminance thumbnails of two selected crops
+            float occluded_crop_weight = 0.5; // the score of a crop taken while the object overlaps with another one is multiplied by this
+        };
+
+        // quality score of a crop in [0, 1], from its sharpness (variance of laplacian), height and height/width ratio
+        // the height and the ratio are those of source_size, the size of the crop in the camera frame (the crop pool of the tracker
+        // resizes all the crops to one size), or of the crop itself when source_size is empty
+        float crop_quality(const cv::Mat &crop, const cv::Size &source_size = cv::Size());
+
+        // select the crops of a dead track for the offline inference, return their indices in descending order of quality
+        // the crops are taken by quality, skipping the ones that look the same as a crop already selected, and
+        // the real-time features of the track (feat_num) reduce the number of crops needed down to min_crops_per_track
+        std::vector<int> select_crops(const std::vector<cv::Mat> &crops, const std::vector<bool> &is_occluded,
+                                      const std::vector<cv::Size> &source_size, const int feat_num, const CropSelectionParam &param);
+    } // namespace reid
+} // namespace ptl
@@ -0,0 +1,67 @@
+#pragma once
+#include <functional>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ptl
+{
+    namespace reid
+    {
+        struct EmbeddingCacheParam
+        {
+            bool enable = true;
+            float match_iou = 0.5;             // min IoU between a detected bbox and a tracking bbox to use the cache of the tracking object
+            float bbox_change_threshold = 0.1; // max change of the position and size of the bbox, relative to the cached bbox
+            float luminance_threshold = 6.0;   // max mean absolute difference (0-255) of the downsampled luminance of the crop
+            int max_reuse_num = 5;             // the feature is computed again after being reused this many times in a row
+        };
+
+        // cache of the reid features of the tracking objects for the real-time reid
+        // a detected bbox matched to a tracking object reuses the feature of the last inference of this object,
+        // if the bbox and the crop barely changed since then (e.g. the pedestrian stands still)
+        class EmbeddingCache
+        {
+        public:
+            using InferenceFunc = std::function<std::vector<float>(const std::vector<cv::Rect2d> &)>;
+
+            void set_param(const EmbeddingCacheParam &param) { param_ = param; }
+
+            //get the features of the detected bboxes, the bboxes that miss the cache are run by inference in one batch
+            //the features of the tracking objects that are gone are dropped
+            std::vector<float> get_features(const cv::Mat &image, const std::vector<cv::Rect2d> &bboxes,
+                                            const std::vector<int> &track_ids, const std::vector<cv::Rect2d> &track_bboxes,
+                                            const InferenceFunc &inference);
+
+            long int hit_num() const { return hit_num_; }
+            long int miss_num() const { return miss_num_; }
+            double hit_rate() const { return hit_num_ + miss_num_ == 0 ? 0 : double(hit_num_) / (hit_num_ + miss_num_); }
+
+        private:
+            struct CacheEntry
+            {
+                std::vector<float> feat;
+                cv::Rect2d bbox;
+                cv::Mat signature;
+                int reuse_num = 0;
+            };
+
+            //match each detected bbox to at most one tracking object by IoU, -1 if none
+            std::vector<int> match_tracks(const std::vector<cv::Rect2d> &bboxes, const std::vector<int> &track_ids,
+                                          const std::vector<cv::Rect2d> &track_bboxes) const;
+
+            //downsampled luminance of the crop of a bbox
+            cv::Mat crop_signature(const cv::Mat &image, const cv::Rect2d &bbox) const;
+
+            bool is_reusable(const CacheEntry &entry, const cv::Rect2d &bbox, const cv::Mat &signature) const;
+
+            EmbeddingCacheParam param_;
+            std::unordered_map<int, CacheEntry> cache;
+            std::mutex mtx; // protect cache
+            long int hit_num_ = 0;
+            long int miss_num_ = 0;
+        };
+    } // namespace reid
+} // namespace ptl
@@ -0,0 +1,90 @@
+#pragma once
+#include <vector>
+
+#include <faiss/Index.h>
+
+namespace ptl
+{
+    namespace reid
+    {
+        // contiguous storage of the features of all the objects in the reid database
+        // each object owns a slab of at most slab_capacity features, and the features of a slab are stored one after another,
+        // so the similarity check of an object only scans a small contiguous block of memory
+        // a feature is identified by its label: slab * slab_capacity + the index of the feature in the slab
+        class FeatureArena
+        {
+        public:
+            FeatureArena() = default;
+            FeatureArena(const int feat_dimension, const int slab_capacity)
+                : feat_dimension_(feat_dimension), slab_capacity_(slab_capacity) {}
+
+            // allocate an empty slab for an object and return the slab index, a recycled slab is reused first
+            int allocate(const int owner_id);
+
+            // allocate a given slab, which must be a free slab or the next new one, return -1 otherwise
+            // (used to replay the allocations of a database)
+            int allocate(const int owner_id, const int slab);
+
+            // empty a slab and detach it from its owner, it is not reused until it is recycled
+            // (an index built on the arena may still hold its labels)
+            void release(const int slab);
+
+            // allow a released slab to be allocated again
+            void recycle(const int slab);
+
+            // append a feature to a slab, return the label of this feature, or -1 if the slab is full
+            faiss::Index::idx_t add(const int slab, const float *feat);
+
+            // replace the feature of a label in place
+            void replace(const faiss::Index::idx_t label, const float *feat);
+
+            // minimum squared L2 distance between a feature and the features in a slab
+            float min_distance(const int slab, const float *feat) const;
+
+            // squared L2 distances between n features and the features in a slab, distance is n x size(slab)
+            // the features are computed in parallel by OpenMP
+            void distance_matrix(const int slab, const float *feat, const int n, float *distance) const;
+
+            // the feature of a slab that is closest to the other features of the slab, return its index in the slab
+            // and its squared L2 distance to its nearest neighbour
+            int most_redundant(const int slab, float &nn_distance) const;
+
+            // exact k nearest neighbour search over the features [slab_start[s], size(s)) of each slab s
+            // slabs not covered by slab_start are searched from the beginning, the output follows faiss
+            void search(const float *feat_query, const faiss::Index::idx_t nq, const faiss::Index::idx_t k,
+                        const std::vector<int> &slab_start, float *distance, faiss::Index::idx_t *index) const;
+
+            // exact k nearest neighbour search over all the features of the given slabs
+            void search_slabs(const float *feat_query, const faiss::Index::idx_t nq, const faiss::Index::idx_t k,
+                              const std::vector<int> &slabs, float *distance, faiss::Index::idx_t *index) const;
+
+            // replace the content of the arena with slab_num slabs of raw data, e.g. from a snapshot of the database
+            // the slabs without owner (-1) can be allocated again, except for slab_released, which wait to be recycled
+            void restore(const int slab_num, const float *feat, const int *feat_num, const int *owner_id,
+                         const std::vector<int> &slab_released = std::vector<int>());
+
+            // copy the features of all the slabs and their labels
+            void snapshot(std::vector<float> &feat, std::vector<faiss::Index::idx_t> &label) const;
+
+            const float *data() const { return feat_.data(); }
+            const float *feature(const faiss::Index::idx_t label) const { return feat_.data() + label * feat_dimension_; }
+            faiss::Index::idx_t label(const int slab, const int i) const { return faiss::Index::idx_t(slab) * slab_capacity_ + i; }
+            int owner(const faiss::Index::idx_t label) const { return owner_id_[label / slab_capacity_]; } // -1 if released
+            int size(const int slab) const { return feat_num_[slab]; }
+            int slab_num() const { return feat_num_.size(); }
+            int slab_capacity() const { return slab_capacity_; }
+
+        private:
+            void search_slabs(const float *feat_query, const faiss::Index::idx_t nq, const faiss::Index::idx_t k, const std::vector<int> &slabs,
+                              const std::vector<int> &slab_start, float *distance, faiss::Index::idx_t *index) const;
+
+            int feat_dimension_ = 2048;
+            int slab_capacity_ = 50;
+
+            std::vector<float> feat_;
+            std::vector<int> feat_num_;
+            std::vector<int> owner_id_;
+            std::vector<int> free_slab_;
+        };
+    } // namespace reid
+} // namespace ptl
@@ -1,4 +1,5 @@
 #pragma once
+#include <condition_variable>
 #include <deque>
 #include <thread>
 #include <mutex>
@@ -10,6 +11,8 @@
 #include <visualization_msgs/MarkerArray.h>
 #include "cv_bridge/cv_bridge.h"
 
+#include "ptl_reid_cpp/crop_selection.h"
+#include "ptl_reid_cpp/embedding_cache.h"
 #include "ptl_reid_cpp/reid_database.h"
 #include "ptl_reid_cpp/reid_inference.h"
 #include "ptl_reid_cpp/util.h"
@@ -22,12 +25,18 @@ namespace ptl
         struct ReidOfflineType
         {
             ReidOfflineType(const cv::Mat &example_image_init, const std::vector<cv::Mat> &images_init,
-                            const geometry_msgs::Point &position_init, const std::vector<float> &feat_init) : example_image(example_image_init), image(images_init),
-                                                                                                              position(position_init), feat_all(feat_init) {}
+                            const geometry_msgs::Point &position_init, const cv::Mat &feat_init,
+                            const double time_init, const std::vector<bool> &is_occluded_init,
+                            const std::vector<cv::Size> &source_size_init)
+                : example_image(example_image_init), image(images_init), is_occluded(is_occluded_init),
+                  source_size(source_size_init), position(position_init), feat(feat_init), time(time_init) {}
             cv::Mat example_image;
             std::vector<cv::Mat> image;
+            std::vector<bool> is_occluded; // whether each image is taken while the object overlaps with another one
+            std::vector<cv::Size> source_size; // size of each image in the camera frame, before the tracker resized it
             geometry_msgs::Point position;
-            std::vector<float> feat_all;
+            cv::Mat feat; // real-time features of the track, one per row (CV_16F or CV_32F), shared with the tracker
+            double time; // last time the object is seen, in seconds
         };
 
         class Reid
@@ -40,14 +49,28 @@ namespace ptl
             // initialize reid engine, create offline reid thread
             void init();
 
-            void reid_realtime(const cv::Mat &image, std::vector<cv::Rect2d> &bboxes, std::vector<float> &feat);
+            // detect the pedestrians and get their reid features, the detected bboxes matched to a tracking object
+            // (track_ids and track_bboxes) may reuse the cached feature of this object
+            // in roi detection, the detector only looks at the regions around track_bboxes, except for the periodic full frame pass
+            void reid_realtime(const cv::Mat &image, std::vector<cv::Rect2d> &bboxes, std::vector<float> &feat,
+                               const std::vector<int> &track_ids = std::vector<int>(),
+                               const std::vector<cv::Rect2d> &track_bboxes = std::vector<cv::Rect2d>());
+
+            // push a dead track to the offline reid buffer and wake up the offline reid thread
+            // only the best crops of the images are inferred, see CropSelectionParam
+            void push_offline(const cv::Mat &example_image, const std::vector<cv::Mat> &images,
+                              const geometry_msgs::Point &position, const cv::Mat &feat, const double time,
+                              const std::vector<bool> &is_occluded = std::vector<bool>(),
+                              const std::vector<cv::Size> &source_size = std::vector<cv::Size>());
 
             ReidDatabase reid_db;
             ReidInference reid_inferencer;
+            EmbeddingCache embedding_cache;
             detector::YoloPedestrainDetector reid_detector;
             std::deque<ReidOfflineType> reid_offline_buffer;
 
-            std::mutex mtx;
+            std::mutex mtx; // protect reid_offline_buffer
+            std::condition_variable offline_cv;
 
         private:
             // load parameters fros
@@ -55,13 +78,15 @@ namespace ptl
 
             void reid_offline();
 
-            void visualize_reid(int reid_id, bool is_new_object);
+            void visualize_reid(const cv::Mat &query_image, int reid_id, bool is_new_object);
 
             visualization_msgs::Marker init_marker(bool is_id_marker);
 
             ros::NodeHandle nh_;
             DataBaseParam db_param;
             InferenceParam inference_param;
+            EmbeddingCacheParam embedding_cache_param;
+            CropSelectionParam crop_selection_param;
             std::thread reid_offline_thread;
 
             ros::Publisher reid_result_pub, detect_result_pub, marker_history_pub;
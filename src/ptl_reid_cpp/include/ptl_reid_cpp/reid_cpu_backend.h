@@ -0,0 +1,43 @@
+#pragma once
+#include <string>
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include <opencv2/dnn.hpp>
+
+#include "ptl_reid_cpp/reid_inference.h"
+#include "ptl_reid_cpp/reid_preprocess.h"
+
+namespace ptl
+{
+    namespace reid
+    {
+        // the onnx model run by OpenCV DNN on the CPU, for the machines without GPU
+        // the crops are preprocessed the same way as the TensorRT backend, so the features are the same up to precision
+        // a cv::dnn::Net is not thread safe, so like the two TensorRT contexts, the real-time and the offline paths run their own copy
+        class ReidCpuBackend : public ReidBackend
+        {
+        public:
+            ReidCpuBackend(const InferenceParam &reid_param) : reid_param_(reid_param) {}
+
+            //load the onnx model of cpu_precision
+            void init() override;
+
+            std::vector<float> do_inference_real_time(const cv::Mat &image, const std::vector<cv::Rect2d> &bboxes) override;
+
+            std::vector<float> do_inference_offline(const std::vector<cv::Mat> &images) override;
+
+        private:
+            //load the onnx model onto the cpu, abort if it fails
+            cv::dnn::Net load_net(const std::string &model_path) const;
+
+            //run a NCHW batch through the model and append the features to result
+            void inference(cv::dnn::Net &net, const cv::Mat &blob, std::vector<float> &result);
+
+            InferenceParam reid_param_;
+            PreprocessParam preprocess_param;
+            cv::dnn::Net net_real_time; // used by the real-time reid thread only
+            cv::dnn::Net net_offline;   // used by the offline reid thread only
+        };
+    } // namespace reid
+} // namespace ptl
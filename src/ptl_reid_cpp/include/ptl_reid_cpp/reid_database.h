@@ -1,8 +1,23 @@
 #pragma once
+#include <algorithm>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
 #include <geometry_msgs/Point.h>
 #include <opencv/cv.h>
 #include <faiss/IndexFlat.h>
+#include <faiss/IndexHNSW.h>
+#include <faiss/IndexIDMap.h>
 #include <faiss/IndexIVFFlat.h>
+#include <faiss/IndexIVFPQ.h>
+#include <faiss/IndexScalarQuantizer.h>
+
+#include "ptl_reid_cpp/feature_arena.h"
+#include "ptl_reid_cpp/reid_snapshot.h"
 
 namespace ptl
 {
@@ -14,69 +29,195 @@ namespace ptl
             float similarity_test_threshold = 150.0;
             float same_id_threshold = 350.0;
             float batch_ratio = 0.55;
-            float max_feat_num_one_object = 50;
+            float max_feat_num_one_object = 50; // also the slab capacity of each object in the feature arena
 
-            // if the total feature is larger than this, use Inverted file in feature database to increase search efficency
+            // if the total feature is larger than this, use Inverted file (or HNSW) in feature database to increase search efficency
             int use_inverted_file_db_threshold = 2500;
             int feat_dimension = 2048;
             int find_first_k = 2;
             int nlist_ratio = 50;
             int sim_check_start_threshold = 5;
+
+            // type of the inverted file: "ivf_flat", "ivf_sq8" (8-bit scalar quantization) or "ivf_pq" (product quantization)
+            // the compressed types only keep codes in the inverted file, the raw features are kept once in the feature arena
+            std::string inverted_file_type = "ivf_sq8";
+            int pq_m = 64;     // number of sub-quantizers of ivf_pq, must divide feat_dimension
+            int rerank_k = 20; // candidates from a compressed inverted file that are re-ranked with the raw features
+
+            // index of the large gallery: "ivf" (inverted file of inverted_file_type, rebuilt when the gallery doubles)
+            // or "hnsw" (HNSW graph, built once and then new features are inserted without retraining)
+            std::string large_db_type = "ivf";
+            int hnsw_m = 32;                // number of neighbours of each node in the HNSW graph
+            int hnsw_ef_construction = 40;  // size of the candidate list when inserting into the HNSW graph
+            int hnsw_ef_search = 64;        // size of the candidate list when searching the HNSW graph, trades speed for recall
+
+            // spatial-temporal filter, an object is not matched if it cannot walk from its last position to the query position in time
+            float max_walking_speed = 0; // m/s, 0 disables the filter
+            float spatial_slack = 2.0;   // m, margin for the localization error
+            int spatial_overfetch = 4;   // k is multiplied by this when the whole gallery is searched and the unreachable objects are dropped
+
+            // retention policies, 0 disables each of them
+            double identity_ttl = 0;  // s, an object that is not seen for this long is evicted
+            int max_identity_num = 0; // the least recently seen objects are evicted beyond this number of objects
+            // when an object has max_feat_num_one_object features, a new feature that passes the similarity test
+            // replaces the most redundant feature of the object if it is more distinct
+            bool diverse_feature_eviction = true;
+            // rebuild the large index without the evicted or replaced features in the background when they are more than this ratio of it
+            float compaction_stale_ratio = 0.2;
+
+            // OpenMP threads of the search and the similarity check of the reid thread, 0 to use the OpenMP default
+            // keep it small to leave the cores to the tracker
+            int num_threads = 0;
+
+            // directory of the persistent snapshot of the database, empty to disable it
+            // the database is loaded from the snapshot on start, and every change is appended to it
+            std::string snapshot_dir = "";
+            int snapshot_checkpoint_interval = 5000; // number of logged changes before compacting them into a new checkpoint
         };
 
+        // exact k nearest neighbour search over nb contiguous features, the output follows faiss (-1 for missing results)
+        void brute_force_search(const float *feat_query, const faiss::Index::idx_t nq, const float *feat_base, const faiss::Index::idx_t nb,
+                                const int feat_dimension, const faiss::Index::idx_t k, float *distance, faiss::Index::idx_t *index);
+
+        // train and populate an inverted file of the type in db_param on the given features and their labels
+        std::unique_ptr<faiss::IndexIVF> build_inverted_file(const std::vector<float> &feat, const std::vector<faiss::Index::idx_t> &label,
+                                                             const DataBaseParam &db_param);
+
+        // build a HNSW graph on the given features and their labels, more features can be added with add_with_ids later
+        std::unique_ptr<faiss::Index> build_hnsw(const std::vector<float> &feat, const std::vector<faiss::Index::idx_t> &label,
+                                                 const DataBaseParam &db_param);
+
+        // set the search parameters of a HNSW graph built by build_hnsw (e.g. after loading it from disk)
+        void set_hnsw_param(faiss::Index &db, const DataBaseParam &db_param);
+
+        // build the index of the large gallery of large_db_type
+        std::unique_ptr<faiss::Index> build_large_db(const std::vector<float> &feat, const std::vector<faiss::Index::idx_t> &label,
+                                                     const DataBaseParam &db_param);
+
+        // search the index of the large gallery, an inverted file is searched with search_inverted_file
+        void search_large_db(const faiss::Index &db, const DataBaseParam &db_param, const float *feat_store,
+                             const faiss::Index::idx_t n, const float *feat_query, const faiss::Index::idx_t k,
+                             float *distance, faiss::Index::idx_t *index);
+
+        // search an inverted file, re-rank the candidates with the raw features if the inverted file is compressed
+        void search_inverted_file(const faiss::IndexIVF &db, const DataBaseParam &db_param, const float *feat_store,
+                                  const faiss::Index::idx_t n, const float *feat_query, const faiss::Index::idx_t k,
+                                  float *distance, faiss::Index::idx_t *index);
+
         class ObjectType
         {
 
         public:
-            ObjectType(const int id_init, const cv::Mat &img, const geometry_msgs::Point &pos_init)
-                : id(id_init), example_image(img), pos(pos_init), feat_dimension(2048), db(2048) {}
+            ObjectType(const int id_init, const cv::Mat &img, const geometry_msgs::Point &pos_init, const int slab_init)
+                : id(id_init), example_image(img), pos(pos_init), slab(slab_init) {}
 
-            ObjectType(const int id_init, const cv::Mat &img, const geometry_msgs::Point &pos_init,
-                       const int feat_dim)
-                : id(id_init), example_image(img), pos(pos_init), feat_dimension(feat_dim), db(feat_dim) {}
-
-            void update_pos(const geometry_msgs::Point &pos_new)
+            void update_pos(const geometry_msgs::Point &pos_new, const double time)
             {
                 pos = pos_new;
+                last_seen = std::max(last_seen, time);
             }
 
-            faiss::IndexFlatL2 db;
             int feat_num = 0;
             int id = 0;
             cv::Mat example_image;
             geometry_msgs::Point pos;
-
-        private:
-            const int feat_dimension;
+            int slab = 0;          // slab of the features of this object in the feature arena
+            double last_seen = 0; // time of the last sighting in seconds, 0 if it is unknown
+            bool is_evicted = false; // the id of an evicted object is never reused
         };
 
         class ReidDatabase
         {
         public:
             ReidDatabase() = default;
-            ReidDatabase(const DataBaseParam &db_param) : db_param_(db_param), db_small(db_param_.feat_dimension) {}
+            ReidDatabase(const DataBaseParam &db_param);
 
             //query a set of image features and update the database
-            int query_and_update(const std::vector<float> &feat_query, const cv::Mat &example_image, const geometry_msgs::Point &position);
+            //time is when the object is seen (in seconds), it is used by the spatial-temporal filter, 0 if it is unknown
+            int query_and_update(const std::vector<float> &feat_query, const cv::Mat &example_image, const geometry_msgs::Point &position,
+                                 const double time = 0);
+
+            //query and update the database with the image features of several objects, the features of all the objects
+            //are searched in one go, and the ids are the same as querying and updating the objects one by one
+            //an object without any feature gets id -1
+            std::vector<int> query_and_update(const std::vector<std::vector<float>> &feat_query, const std::vector<cv::Mat> &example_image,
+                                              const std::vector<geometry_msgs::Point> &position, const std::vector<double> &time);
             int max_id = 0;
             std::vector<ObjectType> object_db;
 
+            //number of times db_large has started building in the background and has been swapped in
+            int db_large_build_num() const { return num_db_large_build; }
+            int db_large_swap_num() const { return num_db_large_swap; }
+
         private:
-            //query a set of features
-            int query(const std::vector<float> &feat_query, bool need_report = true);
+            friend class ReidSnapshot;
+
+            //get the id of a set of features from the ids and distances of their k nearest neighbours
+            int vote_id(const std::vector<faiss::Index::idx_t> &index, const std::vector<float> &distance, bool need_report = true);
+
+            //find the objects that can reach the position at the time since their last sighting, return their number of features
+            faiss::Index::idx_t find_reachable(const geometry_msgs::Point &position, const double time,
+                                               std::vector<char> &is_candidate, std::vector<int> &slabs);
+
+            //keep the first k valid results of each feature that belong to the candidate objects (all objects if is_candidate is empty)
+            //and are not in label_excluded
+            void select_result(const float *distance_all, const faiss::Index::idx_t *index_all, const faiss::Index::idx_t n,
+                               const faiss::Index::idx_t k_all, const std::vector<char> &is_candidate,
+                               const std::unordered_set<faiss::Index::idx_t> &label_excluded,
+                               float *distance, faiss::Index::idx_t *index);
+
+            //merge an exact search over the features of the given labels into the sorted search results of n features
+            void merge_exact_search(const float *feat, const faiss::Index::idx_t n, const std::vector<faiss::Index::idx_t> &label,
+                                    float *distance, faiss::Index::idx_t *index);
 
             //report the query result
             void report_query(const std::vector<faiss::Index::idx_t> &index, const std::vector<float> &distance);
 
             //update the database
-            void update(const std::vector<float> &feat_query, int id, const cv::Mat &example_image, const geometry_msgs::Point &position);
+            //the labels of the features added or replaced are appended to label_update
+            void update(const std::vector<float> &feat_query, int id, const cv::Mat &example_image, const geometry_msgs::Point &position,
+                        const double time, std::vector<faiss::Index::idx_t> &label_update);
+
+            //update the object datbase, return the number of features added to the feature arena
+            int update_object_db(const std::vector<float> &feat_query, const int id, const cv::Mat &example_image,
+                                 const geometry_msgs::Point &position, const double time, std::vector<faiss::Index::idx_t> &label_update);
 
-            //update the object datbase
-            void update_object_db(const std::vector<float> &feat_query, std::vector<float> &feat_update, const int id,
-                                  const cv::Mat &example_image, const geometry_msgs::Point &position);
+            //replace a feature of an object in place, its old entry in db_large becomes stale
+            void replace_feature(const faiss::Index::idx_t label, const float *feat);
+
+            //apply the retention policies at the time, the objects of keep_ids (e.g. just returned by a query) are not evicted
+            void evict_objects(const double time_now, const std::vector<int> &keep_ids);
+
+            //evict an object and release its features, its old entries in db_large become stale
+            void evict_object(const int id);
+
+            //whether a search result is a live feature with the content it had when db_large was built
+            bool is_valid_result(const faiss::Index::idx_t label) const
+            {
+                return label >= 0 && feat_arena.owner(label) >= 0 && label_replaced_count.count(label) == 0;
+            }
 
             //update the feature datbase
-            void update_feature_db(const std::vector<float> &feat_update, const int id);
+            void update_feature_db(const int feat_num_update, const int id);
+
+            //search the feature database, results of the inverted file and the delta database are merged
+            void search_feature_db(const faiss::Index::idx_t n, const float *feat, const faiss::Index::idx_t k,
+                                   float *distance, faiss::Index::idx_t *index);
+
+            //start building db_large when the database grows large enough, or when db_large has too many stale entries
+            void maybe_start_building_db();
+
+            //go back to brute-force search, the stale entries go away with db_large
+            void drop_db_large();
+
+            //train a new inverted file on a snapshot of the features in a background thread
+            void start_building_db();
+
+            //swap in the inverted file when the background building is done
+            void try_swap_db();
+
+            //insert the features of a slab that are not in db_large yet, only for the HNSW graph
+            void add_to_db_large(const int slab);
 
             void report_object_db();
 
@@ -84,14 +225,36 @@ namespace ptl
 
             DataBaseParam db_param_;
 
-            bool is_using_db_small = true;
-            faiss::IndexFlatL2 db_small;
-            faiss::IndexIVFFlat *db_large;
+            // the gallery is searched in db_large (the first slab_num_in_db_large[s] features of each slab s) plus a brute-force
+            // search over the rest of the feature arena (the delta database)
+            // db_large is nullptr until the gallery is large enough to use an inverted file or a HNSW graph
+            std::unique_ptr<faiss::Index> db_large;
+            std::future<std::unique_ptr<faiss::Index>> db_large_building;
+            bool is_building_db = false;
 
             faiss::Index::idx_t num_feat = 0;
+            faiss::Index::idx_t num_feat_in_db_large = 0;
+            int num_db_large_build = 0;
+            int num_db_large_swap = 0;
             faiss::Index::idx_t num_feat_when_building_db = 0;
-            std::vector<float> feat_all;
-            std::vector<faiss::Index::idx_t> id_all;
+            std::vector<int> slab_num_in_db_large;
+            std::vector<int> slab_num_when_building_db;
+
+            // entries of db_large that are stale until it is rebuilt without them (compaction)
+            // the replaced features are searched exactly, the slabs of evicted objects are reused after the compaction
+            faiss::Index::idx_t num_feat_stale = 0;
+            faiss::Index::idx_t num_feat_stale_in_building = 0; // stale entries of the db_large being built
+            std::vector<faiss::Index::idx_t> label_replaced;
+            std::unordered_map<faiss::Index::idx_t, int> label_replaced_count;
+            size_t label_replaced_when_building = 0;
+            std::vector<int> slab_released;
+            size_t slab_released_when_building = 0;
+
+            // the only copy of the raw features in the feature database, the labels in db_large are arena labels
+            FeatureArena feat_arena;
+
+            // nullptr if the snapshot is disabled
+            std::unique_ptr<ReidSnapshot> snapshot;
         };
 
     } // namespace reid
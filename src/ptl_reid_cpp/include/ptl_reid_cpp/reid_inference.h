@@ -1,64 +1,45 @@
 #pragma once
 #include <iostream>
-#include <fstream>
 #include <memory>
-
+#include <string>
 #include <vector>
 
-#include <NvInfer.h>
-#include <NvOnnxParser.h>
-#include <NvInferPlugin.h>
-#include <NvInferRuntimeCommon.h>
-
-#include <cuda_runtime_api.h>
-#include <opencv2/imgcodecs.hpp>
-#include <opencv2/core/cuda.hpp>
-#include <opencv2/cudawarping.hpp>
 #include <opencv2/core.hpp>
-#include <opencv2/cudaarithm.hpp>
-#include <algorithm>
-#include <numeric>
-#include <ros/package.h>
+
 namespace ptl
 {
     namespace reid
     {
-
-        class Logger : public nvinfer1::ILogger
-        {
-        public:
-            void log(Severity severity, const char *msg) override
-            {
-                // remove this 'if' if you need more logged info
-                if ((severity == Severity::kERROR) || (severity == Severity::kINTERNAL_ERROR))
-                {
-                    std::cout << msg << "\n";
-                }
-            }
-        };
-
-        // destroy TensorRT objects if something goes wrong
-        struct TRTDestroy
-        {
-            template <class T>
-            void operator()(T *obj) const
-            {
-                if (obj)
-                {
-                    obj->destroy();
-                }
-            }
-        };
-
-        template <class T>
-        using TRTUniquePtr = std::unique_ptr<T, TRTDestroy>;
-
         struct InferenceParam
         {
+            std::string backend = "tensorrt"; // "tensorrt" or "cpu"
             int inference_real_time_batch_size = 4;
             int inference_offline_batch_size = 8;
+            int offline_max_batch_objects = 8; // maximal number of dead tracks that are coalesced into one offline reid round
             std::string engine_file_name = "reid_engine.engine";
             std::string onnx_file_name = "reid.onnx";
+
+            // cpu backend
+            int cpu_num_threads = 0;             // threads of OpenCV (for the whole process), 0 to keep the OpenCV default
+            std::string cpu_precision = "fp32";  // "fp32" runs onnx_file_name, "int8" runs onnx_int8_file_name
+            std::string onnx_int8_file_name = "reid_int8.onnx"; // the model quantized offline (QDQ or QLinear operators)
+        };
+
+        // an inference engine of the reid model
+        // the features of the images are concatenated in the order of the images, each of them has the output size of the model
+        class ReidBackend
+        {
+        public:
+            virtual ~ReidBackend() = default;
+
+            //load the model, kill the node if it fails
+            virtual void init() = 0;
+
+            //do inference for real time thread
+            virtual std::vector<float> do_inference_real_time(const cv::Mat &image, const std::vector<cv::Rect2d> &bboxes) = 0;
+
+            //do inference for offline thread (back-end reid)
+            virtual std::vector<float> do_inference_offline(const std::vector<cv::Mat> &images) = 0;
         };
 
         class ReidInference
@@ -67,38 +48,24 @@ namespace ptl
             ReidInference() = default;
             ReidInference(const InferenceParam &reid_param) : reid_param_(reid_param) {}
 
-            //initialize the engine
+            //create the backend of reid_param_.backend and initialize it
             void init();
 
             //do inference for real time thread
-            std::vector<float> do_inference_real_time(const cv::Mat &image, const std::vector<cv::Rect2d> &bboxes);
+            std::vector<float> do_inference_real_time(const cv::Mat &image, const std::vector<cv::Rect2d> &bboxes)
+            {
+                return backend->do_inference_real_time(image, bboxes);
+            }
 
             //do inference for offline thread (back-end reid)
-            std::vector<float> do_inference_offline(const std::vector<cv::Mat> &images);
+            std::vector<float> do_inference_offline(const std::vector<cv::Mat> &images)
+            {
+                return backend->do_inference_offline(images);
+            }
 
         private:
-            bool load_engine(const std::string &engine_path);
-            bool parse_onnx_model(const std::string &model_path);
-            void save_engine(const std::string &engine_path);
-
-            void data_preprocesss(const cv::Mat &image, std::vector<cv::Rect2d>::const_iterator bboxes_begin,
-                                  std::vector<cv::Rect2d>::const_iterator bboxes_end, float *gpu_input);
-            void data_preprocesss(std::vector<cv::Mat>::const_iterator image_begin,
-                                  std::vector<cv::Mat>::const_iterator image_end,
-                                  float *gpu_input);
-
-            void inference(std::vector<void *> &buffers, bool is_real_time);
-
-            void result_postprocess(float *gpu_output, std::vector<float> &cpu_output);
-
-            TRTUniquePtr<nvinfer1::ICudaEngine> engine{nullptr};
-            TRTUniquePtr<nvinfer1::IExecutionContext> context_real_time{nullptr};
-            TRTUniquePtr<nvinfer1::IExecutionContext> context_offline{nullptr};
-            Logger gLogger;
-
             InferenceParam reid_param_;
-
-            std::vector<void *> buffers;
+            std::unique_ptr<ReidBackend> backend;
         };
     } // namespace reid
-} // namespace ptl
\ No newline at end of file
+} // namespace ptl
@@ -0,0 +1,32 @@
+#pragma once
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ptl
+{
+    namespace reid
+    {
+        // input of the reid model, mean and std are in rgb order
+        // the default keeps the raw pixel values, which is what the onnx model of fast-reid expects (it normalizes inside)
+        struct PreprocessParam
+        {
+            int width = 128;
+            int height = 256;
+            float mean[3] = {0.f, 0.f, 0.f};
+            float std[3] = {1.f, 1.f, 1.f};
+        };
+
+        // crop a bgr image, convert it to rgb, resize it (nearest, same as cv::INTER_NEAREST) and normalize it
+        // in a single pass, the result is written to output as planar CHW floats of 3 x height x width
+        void preprocess_crop(const cv::Mat &image, const cv::Rect &roi, const PreprocessParam &param, float *output);
+
+        // preprocess the crops of the bounding boxes of a frame into a NCHW batch, the crops are processed in parallel
+        void preprocess_crops(const cv::Mat &image, std::vector<cv::Rect2d>::const_iterator bboxes_begin,
+                              std::vector<cv::Rect2d>::const_iterator bboxes_end, const PreprocessParam &param, float *output);
+
+        // preprocess whole images into a NCHW batch, the images are processed in parallel
+        void preprocess_images(std::vector<cv::Mat>::const_iterator image_begin, std::vector<cv::Mat>::const_iterator image_end,
+                               const PreprocessParam &param, float *output);
+    } // namespace reid
+} // namespace ptl
@@ -0,0 +1,66 @@
+#pragma once
+#include <cstdint>
+#include <fstream>
+#include <string>
+
+#include <faiss/Index.h>
+#include <geometry_msgs/Point.h>
+#include <opencv/cv.h>
+
+namespace ptl
+{
+    namespace reid
+    {
+        class ReidDatabase;
+
+        // persistent snapshot of a reid database in a directory, it is made of
+        // checkpoint.bin: a compacted copy of the whole database, memory-mapped when loading
+        // inverted_file_<seq>.index: the inverted file or HNSW graph of the checkpoint (if any), loaded by faiss (inverted lists are memory-mapped)
+        // segment.bin: append-only log of the changes after the checkpoint, replayed when loading
+        class ReidSnapshot
+        {
+        public:
+            ReidSnapshot(const std::string &dir, const int checkpoint_interval);
+
+            //false if the directory can not be created, the snapshot must not be used then
+            bool valid() const { return is_valid_; }
+
+            //load the checkpoint and replay the segment into an empty database, return false if there is no snapshot
+            bool load(ReidDatabase &db);
+
+            //compact the database into a new checkpoint and start a new segment
+            void checkpoint(const ReidDatabase &db);
+
+            //log the changes of the database to the segment
+            void log_new_object(const int id, const int slab, const geometry_msgs::Point &pos, const cv::Mat &example_image);
+            void log_feature(const int slab, const float *feat, const int feat_dimension);
+            void log_position(const int id, const geometry_msgs::Point &pos, const double time);
+            void log_replace_feature(const faiss::Index::idx_t label, const float *feat, const int feat_dimension);
+            void log_evict_object(const int id);
+            void flush() { segment.flush(); }
+
+            //whether the segment is long enough to be compacted into a new checkpoint
+            bool need_checkpoint() const { return segment_record_num >= checkpoint_interval_; }
+
+        private:
+            //load the checkpoint into an empty database, return false if there is no valid checkpoint
+            bool load_checkpoint(ReidDatabase &db);
+
+            //replay the valid records of the segment of the current checkpoint, return the size of the valid part
+            size_t replay_segment(ReidDatabase &db);
+
+            //start an empty segment after the current checkpoint
+            void reset_segment();
+
+            std::string file_path(const std::string &name) const { return dir_ + "/" + name; }
+            std::string inverted_file_name(const uint32_t seq) const { return "inverted_file_" + std::to_string(seq) + ".index"; }
+
+            std::string dir_;
+            bool is_valid_ = true;
+            int checkpoint_interval_;
+            uint32_t checkpoint_seq = 0;
+            int segment_record_num = 0;
+            std::ofstream segment;
+        };
+    } // namespace reid
+} // namespace ptl
@@ -0,0 +1,98 @@
+#pragma once
+#include <iostream>
+#include <fstream>
+#include <memory>
+
+#include <vector>
+
+#include <NvInfer.h>
+#include <NvOnnxParser.h>
+#include <NvInferPlugin.h>
+#include <NvInferRuntimeCommon.h>
+
+#include <cuda_runtime_api.h>
+#include <opencv2/imgcodecs.hpp>
+#include <opencv2/core.hpp>
+#include <algorithm>
+#include <numeric>
+#include <ros/package.h>
+
+#include "ptl_reid_cpp/reid_inference.h"
+#include "ptl_reid_cpp/reid_preprocess.h"
+namespace ptl
+{
+    namespace reid
+    {
+
+        class Logger : public nvinfer1::ILogger
+        {
+        public:
+            void log(Severity severity, const char *msg) override
+            {
+                // remove this 'if' if you need more logged info
+                if ((severity == Severity::kERROR) || (severity == Severity::kINTERNAL_ERROR))
+                {
+                    std::cout << msg << "\n";
+                }
+            }
+        };
+
+        // destroy TensorRT objects if something goes wrong
+        struct TRTDestroy
+        {
+            template <class T>
+            void operator()(T *obj) const
+            {
+                if (obj)
+                {
+                    obj->destroy();
+                }
+            }
+        };
+
+        template <class T>
+        using TRTUniquePtr = std::unique_ptr<T, TRTDestroy>;
+
+        // TensorRT engine built from the onnx model, the crops are preprocessed on the GPU
+        class ReidTensorRTBackend : public ReidBackend
+        {
+        public:
+            ReidTensorRTBackend(const InferenceParam &reid_param) : reid_param_(reid_param) {}
+
+            //load the engine file, or build it from the onnx model and save it
+            void init() override;
+
+            std::vector<float> do_inference_real_time(const cv::Mat &image, const std::vector<cv::Rect2d> &bboxes) override;
+
+            std::vector<float> do_inference_offline(const std::vector<cv::Mat> &images) override;
+
+        private:
+            bool load_engine(const std::string &engine_path);
+            bool parse_onnx_model(const std::string &model_path);
+            void save_engine(const std::string &engine_path);
+
+            void data_preprocesss(const cv::Mat &image, std::vector<cv::Rect2d>::const_iterator bboxes_begin,
+                                  std::vector<cv::Rect2d>::const_iterator bboxes_end, float *gpu_input);
+            void data_preprocesss(std::vector<cv::Mat>::const_iterator image_begin,
+                                  std::vector<cv::Mat>::const_iterator image_end,
+                                  float *gpu_input);
+
+            void inference(std::vector<void *> &buffers, bool is_real_time);
+
+            void result_postprocess(float *gpu_output, std::vector<float> &cpu_output);
+
+            TRTUniquePtr<nvinfer1::ICudaEngine> engine{nullptr};
+            TRTUniquePtr<nvinfer1::IExecutionContext> context_real_time{nullptr};
+            TRTUniquePtr<nvinfer1::IExecutionContext> context_offline{nullptr};
+            Logger gLogger;
+
+            InferenceParam reid_param_;
+            PreprocessParam preprocess_param;
+            //preprocessed batch before it is uploaded, one for each path since they run on different threads
+            std::vector<float> input_host_real_time;
+            std::vector<float> input_host_offline;
+
+            std::vector<void *> buffers;
+        };
+    } // namespace reid
+} // namespace ptl
\ No newline at end of file
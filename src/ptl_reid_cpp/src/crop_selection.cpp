@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+#include <opencv2/imgproc.hpp>
+
+#include "ptl_reid_cpp/crop_selection.h"
+
+namespace ptl
+{
+    namespace reid
+    {
+        float crop_quality(const cv::Mat &crop, const cv::Size &source_size)
+        {
+            if (crop.empty())
+            {
+                return 0;
+            }
+
+            //sharpness on a fixed size, so that it does not depend on the size of the crop
+            cv::Mat gray, resized, laplacian;
+            cv::cvtColor(crop, gray, cv::COLOR_BGR2GRAY);
+            cv::resize(gray, resized, cv::Size(64, 128), 0, 0, cv::INTER_AREA);
+            cv::Laplacian(resized, laplacian, CV_32F);
+            cv::Scalar mean, stddev;
+            cv::meanStdDev(laplacian, mean, stddev);
+            const float sharpness = std::min(1.0, stddev[0] * stddev[0] / 100.0);
+
+            //the model takes 128 x 256 crops of standing pedestrians
+            const cv::Size original = source_size.area() > 0 ? source_size : crop.size();
+            const float size = std::min(1.0f, original.height / 256.0f);
+            const float aspect = std::exp(-std::abs(std::log(1.0f * original.height / original.width / 2.0f)));
+            return sharpness * size * aspect;
+        }
+
+        std::vector<int> select_crops(const std::vector<cv::Mat> &crops, const std::vector<bool> &is_occluded,
+                                      const std::vector<cv::Size> &source_size, const int feat_num, const CropSelectionParam &param)
+        {
+            std::vector<int> index(crops.size());
+            std::iota(index.begin(), index.end(), 0);
+            if (param.max_crops_per_track <= 0)
+            {
+                return index;
+            }
+
+            std::vector<float> score(crops.size());
+            for (int i = 0; i < crops.size(); i++)
+            {
+                score[i] = crop_quality(crops[i], i < source_size.size() ? source_size[i] : cv::Size()) *
+                           (i < is_occluded.size() && is_occluded[i] ? param.occluded_crop_weight : 1.0f);
+            }
+            std::stable_sort(index.begin(), index.end(), [&](const int a, const int b) { return score[a] > score[b]; });
+
+            //take the best crops that differ from the ones already taken
+            const int crop_num = std::max(param.min_crops_per_track, param.max_crops_per_track - feat_num);
+            std::vector<int> selected;
+            std::vector<cv::Mat> thumbnail;
+            for (auto i : index)
+            {
+                if (selected.size() >= crop_num || crops[i].empty())
+                {
+                    break;
+                }
+                cv::Mat small, gray;
+                cv::resize(crops[i], small, cv::Size(8, 16), 0, 0, cv::INTER_AREA);
+                cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+                bool is_diverse = true;
+                for (const auto &t : thumbnail)
+                {
+                    if (cv::norm(gray, t, cv::NORM_L1) / gray.total() < param.diversity_threshold)
+                    {
+                        is_diverse = false;
+                        break;
+                    }
+                }
+                if (is_diverse)
+                {
+                    selected.push_back(i);
+                    thumbnail.push_back(gray);
+                }
+            }
+            return selected;
+        }
+    } // namespace reid
+} // namespace ptl
@@ -0,0 +1,150 @@
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+
+#include <opencv2/imgproc.hpp>
+
+#include "ptl_reid_cpp/embedding_cache.h"
+
+namespace ptl
+{
+    namespace reid
+    {
+        std::vector<float> EmbeddingCache::get_features(const cv::Mat &image, const std::vector<cv::Rect2d> &bboxes,
+                                                        const std::vector<int> &track_ids, const std::vector<cv::Rect2d> &track_bboxes,
+                                                        const InferenceFunc &inference)
+        {
+            if (!param_.enable || bboxes.empty())
+            {
+                return bboxes.empty() ? std::vector<float>() : inference(bboxes);
+            }
+
+            //find the bboxes whose cached feature can be reused
+            std::vector<int> track_of_bbox = match_tracks(bboxes, track_ids, track_bboxes);
+            std::vector<cv::Mat> signature(bboxes.size());
+            std::vector<std::vector<float>> cached(bboxes.size()); // copied, another thread may change the cache meanwhile
+            std::vector<cv::Rect2d> bboxes_miss;
+            std::vector<int> index_miss;
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                std::unordered_set<int> alive(track_ids.begin(), track_ids.end());
+                for (auto it = cache.begin(); it != cache.end();)
+                {
+                    it = alive.count(it->first) ? std::next(it) : cache.erase(it);
+                }
+
+                for (int i = 0; i < bboxes.size(); i++)
+                {
+                    if (track_of_bbox[i] >= 0)
+                    {
+                        signature[i] = crop_signature(image, bboxes[i]);
+                        auto it = cache.find(track_of_bbox[i]);
+                        if (it != cache.end() && is_reusable(it->second, bboxes[i], signature[i]))
+                        {
+                            it->second.reuse_num++;
+                            cached[i] = it->second.feat;
+                            continue;
+                        }
+                    }
+                    bboxes_miss.push_back(bboxes[i]);
+                    index_miss.push_back(i);
+                }
+                hit_num_ += bboxes.size() - bboxes_miss.size();
+                miss_num_ += bboxes_miss.size();
+            }
+
+            std::vector<float> feat_miss;
+            if (!bboxes_miss.empty())
+            {
+                feat_miss = inference(bboxes_miss);
+            }
+            const size_t feat_size = bboxes_miss.empty() ? cached[0].size() : feat_miss.size() / bboxes_miss.size();
+
+            //assemble the features in the order of the bboxes and refresh the cache with the new features
+            std::lock_guard<std::mutex> lk(mtx);
+            std::vector<float> feat(bboxes.size() * feat_size);
+            for (int j = 0; j < index_miss.size(); j++)
+            {
+                const int i = index_miss[j];
+                std::copy(feat_miss.begin() + j * feat_size, feat_miss.begin() + (j + 1) * feat_size, feat.begin() + i * feat_size);
+                if (track_of_bbox[i] >= 0)
+                {
+                    CacheEntry &entry = cache[track_of_bbox[i]];
+                    entry.feat.assign(feat_miss.begin() + j * feat_size, feat_miss.begin() + (j + 1) * feat_size);
+                    entry.bbox = bboxes[i];
+                    entry.signature = signature[i];
+                    entry.reuse_num = 0;
+                }
+            }
+            for (int i = 0; i < bboxes.size(); i++)
+            {
+                if (!cached[i].empty())
+                {
+                    std::copy(cached[i].begin(), cached[i].end(), feat.begin() + i * feat_size);
+                }
+            }
+            return feat;
+        }
+
+        std::vector<int> EmbeddingCache::match_tracks(const std::vector<cv::Rect2d> &bboxes, const std::vector<int> &track_ids,
+                                                      const std::vector<cv::Rect2d> &track_bboxes) const
+        {
+            //greedy matching from the highest IoU
+            std::vector<std::pair<double, std::pair<int, int>>> pairs;
+            for (int i = 0; i < bboxes.size(); i++)
+            {
+                for (int j = 0; j < track_bboxes.size(); j++)
+                {
+                    double overlap = (bboxes[i] & track_bboxes[j]).area();
+                    double iou = overlap / (bboxes[i].area() + track_bboxes[j].area() - overlap);
+                    if (iou >= param_.match_iou)
+                    {
+                        pairs.push_back(std::make_pair(iou, std::make_pair(i, j)));
+                    }
+                }
+            }
+            std::sort(pairs.begin(), pairs.end(), [](const std::pair<double, std::pair<int, int>> &a, const std::pair<double, std::pair<int, int>> &b) { return a.first > b.first; });
+
+            std::vector<int> track_of_bbox(bboxes.size(), -1);
+            std::vector<bool> track_used(track_bboxes.size(), false);
+            for (const auto &p : pairs)
+            {
+                if (track_of_bbox[p.second.first] < 0 && !track_used[p.second.second])
+                {
+                    track_of_bbox[p.second.first] = track_ids[p.second.second];
+                    track_used[p.second.second] = true;
+                }
+            }
+            return track_of_bbox;
+        }
+
+        cv::Mat EmbeddingCache::crop_signature(const cv::Mat &image, const cv::Rect2d &bbox) const
+        {
+            cv::Mat crop = image(cv::Rect(bbox) & cv::Rect(0, 0, image.cols, image.rows));
+            cv::Mat small, gray;
+            if (crop.empty())
+            {
+                return gray;
+            }
+            cv::resize(crop, small, cv::Size(8, 16), 0, 0, cv::INTER_AREA);
+            cv::cvtColor(small, gray, cv::COLOR_BGR2GRAY);
+            return gray;
+        }
+
+        bool EmbeddingCache::is_reusable(const CacheEntry &entry, const cv::Rect2d &bbox, const cv::Mat &signature) const
+        {
+            if (entry.reuse_num >= param_.max_reuse_num || signature.empty() || entry.signature.empty())
+            {
+                return false;
+            }
+            const cv::Rect2d &b = entry.bbox;
+            double bbox_change = std::max(std::max(std::abs(bbox.x - b.x) / b.width, std::abs(bbox.y - b.y) / b.height),
+                                          std::max(std::abs(bbox.width - b.width) / b.width, std::abs(bbox.height - b.height) / b.height));
+            if (bbox_change > param_.bbox_change_threshold)
+            {
+                return false;
+            }
+            return cv::norm(signature, entry.signature, cv::NORM_L1) / signature.total() <= param_.luminance_threshold;
+        }
+    } // namespace reid
+} // namespace ptl
@@ -0,0 +1,216 @@
+#include <algorithm>
+#include <limits>
+#include <numeric>
+#include <queue>
+
+#include <faiss/utils/distances.h>
+
+#include "ptl_reid_cpp/feature_arena.h"
+
+using idx_t = faiss::Index::idx_t;
+namespace ptl
+{
+    namespace reid
+    {
+        int FeatureArena::allocate(const int owner_id)
+        {
+            if (!free_slab_.empty())
+            {
+                int slab = free_slab_.back();
+                free_slab_.pop_back();
+                feat_num_[slab] = 0;
+                owner_id_[slab] = owner_id;
+                return slab;
+            }
+            feat_.resize(feat_.size() + size_t(slab_capacity_) * feat_dimension_);
+            feat_num_.push_back(0);
+            owner_id_.push_back(owner_id);
+            return feat_num_.size() - 1;
+        }
+
+        int FeatureArena::allocate(const int owner_id, const int slab)
+        {
+            if (slab == slab_num())
+            {
+                feat_.resize(feat_.size() + size_t(slab_capacity_) * feat_dimension_);
+                feat_num_.push_back(0);
+                owner_id_.push_back(owner_id);
+                return slab;
+            }
+            auto it = std::find(free_slab_.begin(), free_slab_.end(), slab);
+            if (it == free_slab_.end())
+            {
+                return -1;
+            }
+            free_slab_.erase(it);
+            feat_num_[slab] = 0;
+            owner_id_[slab] = owner_id;
+            return slab;
+        }
+
+        void FeatureArena::release(const int slab)
+        {
+            feat_num_[slab] = 0;
+            owner_id_[slab] = -1;
+        }
+
+        void FeatureArena::recycle(const int slab)
+        {
+            free_slab_.push_back(slab);
+        }
+
+        idx_t FeatureArena::add(const int slab, const float *feat)
+        {
+            if (feat_num_[slab] >= slab_capacity_)
+            {
+                return -1;
+            }
+            idx_t l = label(slab, feat_num_[slab]);
+            std::copy(feat, feat + feat_dimension_, feat_.begin() + l * feat_dimension_);
+            feat_num_[slab]++;
+            return l;
+        }
+
+        void FeatureArena::replace(const idx_t label, const float *feat)
+        {
+            std::copy(feat, feat + feat_dimension_, feat_.begin() + label * feat_dimension_);
+        }
+
+        int FeatureArena::most_redundant(const int slab, float &nn_distance) const
+        {
+            const int n = feat_num_[slab];
+            std::vector<float> distance(size_t(n) * n);
+            for (int i = 0; i < n; i++)
+            {
+                faiss::fvec_L2sqr_ny(distance.data() + i * n, feature(label(slab, i)), feature(label(slab, 0)), feat_dimension_, n);
+            }
+
+            int redundant = 0;
+            nn_distance = std::numeric_limits<float>::max();
+            for (int i = 0; i < n; i++)
+            {
+                for (int j = 0; j < n; j++)
+                {
+                    if (i != j && distance[i * n + j] < nn_distance)
+                    {
+                        nn_distance = distance[i * n + j];
+                        redundant = i;
+                    }
+                }
+            }
+            return redundant;
+        }
+
+        float FeatureArena::min_distance(const int slab, const float *feat) const
+        {
+            if (feat_num_[slab] == 0)
+            {
+                return std::numeric_limits<float>::max();
+            }
+            std::vector<float> distance(feat_num_[slab]);
+            faiss::fvec_L2sqr_ny(distance.data(), feat, feature(label(slab, 0)), feat_dimension_, feat_num_[slab]);
+            return *std::min_element(distance.begin(), distance.end());
+        }
+
+        void FeatureArena::distance_matrix(const int slab, const float *feat, const int n, float *distance) const
+        {
+            const int m = feat_num_[slab];
+#pragma omp parallel for if (n > 1 && m > 0)
+            for (int i = 0; i < n; i++)
+            {
+                faiss::fvec_L2sqr_ny(distance + size_t(i) * m, feat + size_t(i) * feat_dimension_, feature(label(slab, 0)), feat_dimension_, m);
+            }
+        }
+
+        void FeatureArena::search(const float *feat_query, const idx_t nq, const idx_t k,
+                                  const std::vector<int> &slab_start, float *distance, idx_t *index) const
+        {
+            std::vector<int> slabs(slab_num());
+            std::iota(slabs.begin(), slabs.end(), 0);
+            search_slabs(feat_query, nq, k, slabs, slab_start, distance, index);
+        }
+
+        void FeatureArena::search_slabs(const float *feat_query, const idx_t nq, const idx_t k, const std::vector<int> &slabs,
+                                        float *distance, idx_t *index) const
+        {
+            search_slabs(feat_query, nq, k, slabs, std::vector<int>(), distance, index);
+        }
+
+        void FeatureArena::search_slabs(const float *feat_query, const idx_t nq, const idx_t k, const std::vector<int> &slabs,
+                                        const std::vector<int> &slab_start, float *distance, idx_t *index) const
+        {
+            std::vector<float> distance_slab(slab_capacity_);
+            for (idx_t i = 0; i < nq; i++)
+            {
+                //max heap of the k nearest features found so far
+                std::priority_queue<std::pair<float, idx_t>> result;
+                for (auto s : slabs)
+                {
+                    int start = s < slab_start.size() ? slab_start[s] : 0;
+                    if (start >= feat_num_[s])
+                    {
+                        continue;
+                    }
+                    faiss::fvec_L2sqr_ny(distance_slab.data(), feat_query + i * feat_dimension_, feature(label(s, start)),
+                                         feat_dimension_, feat_num_[s] - start);
+                    for (int j = 0; j < feat_num_[s] - start; j++)
+                    {
+                        if (result.size() < k)
+                        {
+                            result.emplace(distance_slab[j], label(s, start + j));
+                        }
+                        else if (distance_slab[j] < result.top().first)
+                        {
+                            result.pop();
+                            result.emplace(distance_slab[j], label(s, start + j));
+                        }
+                    }
+                }
+
+                //output in ascending order of distance
+                for (idx_t j = k - 1; j >= 0; j--)
+                {
+                    if (j >= result.size())
+                    {
+                        distance[i * k + j] = std::numeric_limits<float>::max();
+                        index[i * k + j] = -1;
+                        continue;
+                    }
+                    distance[i * k + j] = result.top().first;
+                    index[i * k + j] = result.top().second;
+                    result.pop();
+                }
+            }
+        }
+
+        void FeatureArena::restore(const int slab_num, const float *feat, const int *feat_num, const int *owner_id,
+                                   const std::vector<int> &slab_released)
+        {
+            feat_.assign(feat, feat + size_t(slab_num) * slab_capacity_ * feat_dimension_);
+            feat_num_.assign(feat_num, feat_num + slab_num);
+            owner_id_.assign(owner_id, owner_id + slab_num);
+            free_slab_.clear();
+            for (int s = slab_num - 1; s >= 0; s--)
+            {
+                if (owner_id_[s] < 0 && std::find(slab_released.begin(), slab_released.end(), s) == slab_released.end())
+                {
+                    free_slab_.push_back(s);
+                }
+            }
+        }
+
+        void FeatureArena::snapshot(std::vector<float> &feat, std::vector<idx_t> &label_all) const
+        {
+            feat.clear();
+            label_all.clear();
+            for (int s = 0; s < slab_num(); s++)
+            {
+                feat.insert(feat.end(), feature(label(s, 0)), feature(label(s, feat_num_[s])));
+                for (int j = 0; j < feat_num_[s]; j++)
+                {
+                    label_all.push_back(label(s, j));
+                }
+            }
+        }
+    } // namespace reid
+} // namespace ptl
@@ -1,3 +1,6 @@
+#include <algorithm>
+#include <chrono>
+
 #include "ptl_reid_cpp/reid.h"
 
 namespace ptl
@@ -10,6 +13,7 @@ namespace ptl
             reid_db = ReidDatabase(db_param);
             reid_inferencer = ReidInference(inference_param);
             reid_inferencer.init();
+            embedding_cache.set_param(embedding_cache_param);
             reid_offline_thread = std::thread(&Reid::reid_offline, this);
 
             reid_result_pub = nh_.advertise<sensor_msgs::Image>("reid_result", 1);
@@ -31,16 +35,50 @@ namespace ptl
             GPARAM(nh_, "/reid_db/find_first_k", db_param.find_first_k);
             GPARAM(nh_, "/reid_db/nlist_ratio", db_param.nlist_ratio);
             GPARAM(nh_, "/reid_db/sim_check_start_threshold", db_param.sim_check_start_threshold);
+            GPARAM(nh_, "/reid_db/inverted_file_type", db_param.inverted_file_type);
+            GPARAM(nh_, "/reid_db/pq_m", db_param.pq_m);
+            GPARAM(nh_, "/reid_db/rerank_k", db_param.rerank_k);
+            GPARAM(nh_, "/reid_db/large_db_type", db_param.large_db_type);
+            GPARAM(nh_, "/reid_db/hnsw_m", db_param.hnsw_m);
+            GPARAM(nh_, "/reid_db/hnsw_ef_construction", db_param.hnsw_ef_construction);
+            GPARAM(nh_, "/reid_db/hnsw_ef_search", db_param.hnsw_ef_search);
+            GPARAM(nh_, "/reid_db/max_walking_speed", db_param.max_walking_speed);
+            GPARAM(nh_, "/reid_db/spatial_slack", db_param.spatial_slack);
+            GPARAM(nh_, "/reid_db/spatial_overfetch", db_param.spatial_overfetch);
+            GPARAM(nh_, "/reid_db/identity_ttl", db_param.identity_ttl);
+            GPARAM(nh_, "/reid_db/max_identity_num", db_param.max_identity_num);
+            GPARAM(nh_, "/reid_db/diverse_feature_eviction", db_param.diverse_feature_eviction);
+            GPARAM(nh_, "/reid_db/compaction_stale_ratio", db_param.compaction_stale_ratio);
+            GPARAM(nh_, "/reid_db/num_threads", db_param.num_threads);
+            GPARAM(nh_, "/reid_db/snapshot_dir", db_param.snapshot_dir);
+            GPARAM(nh_, "/reid_db/snapshot_checkpoint_interval", db_param.snapshot_checkpoint_interval);
 
+            GPARAM(nh_, "/reid_inference/backend", inference_param.backend);
             GPARAM(nh_, "/reid_inference/engine_file_name", inference_param.engine_file_name);
             GPARAM(nh_, "/reid_inference/onnx_file_name", inference_param.onnx_file_name);
             GPARAM(nh_, "/reid_inference/inference_offline_batch_size", inference_param.inference_offline_batch_size);
             GPARAM(nh_, "/reid_inference/inference_real_time_batch_size", inference_param.inference_real_time_batch_size);
+            GPARAM(nh_, "/reid_inference/offline_max_batch_objects", inference_param.offline_max_batch_objects);
+            GPARAM(nh_, "/reid_inference/cpu_num_threads", inference_param.cpu_num_threads);
+            GPARAM(nh_, "/reid_inference/cpu_precision", inference_param.cpu_precision);
+            GPARAM(nh_, "/reid_inference/onnx_int8_file_name", inference_param.onnx_int8_file_name);
+
+            GPARAM(nh_, "/embedding_cache/enable", embedding_cache_param.enable);
+            GPARAM(nh_, "/embedding_cache/match_iou", embedding_cache_param.match_iou);
+            GPARAM(nh_, "/embedding_cache/bbox_change_threshold", embedding_cache_param.bbox_change_threshold);
+            GPARAM(nh_, "/embedding_cache/luminance_threshold", embedding_cache_param.luminance_threshold);
+            GPARAM(nh_, "/embedding_cache/max_reuse_num", embedding_cache_param.max_reuse_num);
+
+            GPARAM(nh_, "/crop_selection/max_crops_per_track", crop_selection_param.max_crops_per_track);
+            GPARAM(nh_, "/crop_selection/min_crops_per_track", crop_selection_param.min_crops_per_track);
+            GPARAM(nh_, "/crop_selection/diversity_threshold", crop_selection_param.diversity_threshold);
+            GPARAM(nh_, "/crop_selection/occluded_crop_weight", crop_selection_param.occluded_crop_weight);
         }
 
-        void Reid::reid_realtime(const cv::Mat &image, std::vector<cv::Rect2d> &bboxes, std::vector<float> &feat)
+        void Reid::reid_realtime(const cv::Mat &image, std::vector<cv::Rect2d> &bboxes, std::vector<float> &feat,
+                                 const std::vector<int> &track_ids, const std::vector<cv::Rect2d> &track_bboxes)
         {
-            reid_detector.detect_pedestrain(image);
+            reid_detector.detect_pedestrain(image, track_bboxes);
             bboxes.clear();
             feat.clear();
             if (!reid_detector.results.empty())
@@ -58,38 +96,100 @@ namespace ptl
             // do reid inference
             if (!bboxes.empty())
             {
-                feat = reid_inferencer.do_inference_real_time(image, bboxes);
+                feat = embedding_cache.get_features(image, bboxes, track_ids, track_bboxes, [&](const std::vector<cv::Rect2d> &bboxes_miss) {
+                    return reid_inferencer.do_inference_real_time(image, bboxes_miss);
+                });
             }
             //TODO dont forget visulize the detector
         }
 
+        void Reid::push_offline(const cv::Mat &example_image, const std::vector<cv::Mat> &images,
+                                const geometry_msgs::Point &position, const cv::Mat &feat, const double time,
+                                const std::vector<bool> &is_occluded, const std::vector<cv::Size> &source_size)
+        {
+            {
+                std::lock_guard<std::mutex> lk(mtx);
+                reid_offline_buffer.emplace_back(example_image, images, position, feat, time, is_occluded, source_size);
+            }
+            offline_cv.notify_one();
+        }
+
         void Reid::reid_offline()
         {
-            ros::Rate r(100);
             while (ros::ok())
             {
-                if (!reid_offline_buffer.empty())
+                //wait for dead tracks, and take all the pending ones (up to offline_max_batch_objects) in one round
+                std::vector<ReidOfflineType> batch;
+                {
+                    std::unique_lock<std::mutex> lk(mtx);
+                    offline_cv.wait_for(lk, std::chrono::milliseconds(100), [this] { return !reid_offline_buffer.empty(); });
+                    while (!reid_offline_buffer.empty() && batch.size() < inference_param.offline_max_batch_objects)
+                    {
+                        batch.push_back(std::move(reid_offline_buffer.front()));
+                        reid_offline_buffer.pop_front();
+                    }
+                }
+                if (batch.empty())
                 {
-                    //do offline inference
-                    std::vector<float> feature_reid = reid_inferencer.do_inference_offline(reid_offline_buffer[0].image);
-                    reid_offline_buffer[0].feat_all.insert(reid_offline_buffer[0].feat_all.end(), feature_reid.begin(), feature_reid.end());
+                    continue;
+                }
 
-                    //udpate database
-                    int previous_max_id = reid_db.max_id;
-                    int id = reid_db.query_and_update(reid_offline_buffer[0].feat_all, reid_offline_buffer[0].example_image, reid_offline_buffer[0].position);
+                //do offline inference on the best crops of each track, the crops of all the tracks are packed into full batches
+                std::vector<cv::Mat> images;
+                for (auto &b : batch)
+                {
+                    std::vector<int> selected = select_crops(b.image, b.is_occluded, b.source_size, b.feat.rows,
+                                                             crop_selection_param);
+                    std::vector<cv::Mat> image_selected;
+                    for (auto i : selected)
+                    {
+                        image_selected.push_back(b.image[i]);
+                    }
+                    std::cout << "Select " << image_selected.size() << " of " << b.image.size() << " crops for offline reid." << std::endl;
+                    b.image = std::move(image_selected);
+                    images.insert(images.end(), b.image.begin(), b.image.end());
+                }
+                std::vector<float> feature_reid = reid_inferencer.do_inference_offline(images);
+                const size_t feat_size = images.empty() ? 0 : feature_reid.size() / images.size();
+                auto feat_it = feature_reid.begin();
+                std::vector<std::vector<float>> feat_query;
+                std::vector<cv::Mat> example_images;
+                std::vector<geometry_msgs::Point> positions;
+                std::vector<double> times;
+                for (auto &b : batch)
+                {
+                    std::vector<float> feat_all;
+                    if (!b.feat.empty())
+                    {
+                        cv::Mat feat_float;
+                        b.feat.convertTo(feat_float, CV_32F);
+                        feat_all.assign(feat_float.ptr<float>(), feat_float.ptr<float>() + feat_float.total());
+                    }
+                    feat_all.insert(feat_all.end(), feat_it, feat_it + b.image.size() * feat_size);
+                    feat_it += b.image.size() * feat_size;
+                    feat_query.push_back(std::move(feat_all));
+                    example_images.push_back(b.example_image);
+                    positions.push_back(b.position);
+                    times.push_back(b.time);
+                }
 
-                    //visualization
-                    visualize_reid(id, previous_max_id != reid_db.max_id);
+                //udpate database
+                int previous_max_id = reid_db.max_id;
+                std::vector<int> ids = reid_db.query_and_update(feat_query, example_images, positions, times);
 
-                    //remove the first object of the buffer
-                    std::lock_guard<std::mutex> lk(mtx);
-                    reid_offline_buffer.pop_front();
+                //visualization, an id is new when it is created by this track
+                for (int i = 0; i < ids.size(); i++)
+                {
+                    if (ids[i] >= 0)
+                    {
+                        bool is_new_object = ids[i] >= previous_max_id && std::find(ids.begin(), ids.begin() + i, ids[i]) == ids.begin() + i;
+                        visualize_reid(example_images[i], ids[i], is_new_object);
+                    }
                 }
-                r.sleep();
             }
         }
 
-        void Reid::visualize_reid(int reid_id, bool is_new_object)
+        void Reid::visualize_reid(const cv::Mat &query_image, int reid_id, bool is_new_object)
         {
             cv::Mat result;
             std::vector<cv::Mat> example_imgs;
@@ -97,8 +197,8 @@ namespace ptl
             //reid result visualization
             if (is_new_object)
             {
-                example_imgs.push_back(reid_offline_buffer[0].example_image);
-                example_imgs.push_back(reid_offline_buffer[0].example_image);
+                example_imgs.push_back(query_image);
+                example_imgs.push_back(query_image);
                 cv::hconcat(example_imgs, result);
                 cv::resize(result, result, cv::Size(512, 512));
                 cv::putText(result, "Add new one!", cv::Point(10, 50),
@@ -106,8 +206,14 @@ namespace ptl
             }
             else
             {
-                example_imgs.push_back(reid_offline_buffer[0].example_image);
-                example_imgs.push_back(reid_db.object_db[reid_id].example_image);
+                //the gallery image is gone once the object is evicted
+                const cv::Mat &gallery_image = reid_db.object_db[reid_id].example_image;
+                if (gallery_image.empty())
+                {
+                    return;
+                }
+                example_imgs.push_back(query_image);
+                example_imgs.push_back(gallery_image);
                 cv::hconcat(example_imgs, result);
                 cv::resize(result, result, cv::Size(512, 512));
                 cv::putText(result, "Query:", cv::Point(10, 50),
@@ -0,0 +1,91 @@
+#include <algorithm>
+#include <cstdlib>
+#include <iostream>
+
+#include <ros/package.h>
+
+#include "ptl_reid_cpp/reid_cpu_backend.h"
+
+namespace ptl
+{
+    namespace reid
+    {
+        void ReidCpuBackend::init()
+        {
+            std::string root_path = ros::package::getPath("ptl_reid_cpp");
+            std::string onnx_file_name = reid_param_.onnx_file_name;
+            if (reid_param_.cpu_precision == "int8")
+            {
+                onnx_file_name = reid_param_.onnx_int8_file_name;
+            }
+            else if (reid_param_.cpu_precision != "fp32")
+            {
+                std::cout << "Unknown cpu precision: " << reid_param_.cpu_precision << ", use fp32 instead." << std::endl;
+            }
+
+            net_real_time = load_net(root_path + "/asset/" + onnx_file_name);
+            net_offline = load_net(root_path + "/asset/" + onnx_file_name);
+            if (reid_param_.cpu_num_threads > 0)
+            {
+                cv::setNumThreads(reid_param_.cpu_num_threads);
+            }
+            std::cout << "Load reid model " << onnx_file_name << " on the CPU successfully!" << std::endl;
+        }
+
+        cv::dnn::Net ReidCpuBackend::load_net(const std::string &model_path) const
+        {
+            cv::dnn::Net net;
+            try
+            {
+                net = cv::dnn::readNetFromONNX(model_path);
+            }
+            catch (const cv::Exception &e)
+            {
+                std::cout << "Fail to load the reid model " << model_path << ": " << e.what() << std::endl;
+            }
+            if (net.empty())
+            {
+                std::cout << "Fail to load the model. Kill the node!" << std::endl;
+                std::abort();
+            }
+            net.setPreferableBackend(cv::dnn::DNN_BACKEND_OPENCV);
+            net.setPreferableTarget(cv::dnn::DNN_TARGET_CPU);
+            return net;
+        }
+
+        std::vector<float> ReidCpuBackend::do_inference_real_time(const cv::Mat &image, const std::vector<cv::Rect2d> &bboxes)
+        {
+            std::vector<float> result;
+            const int batch_size = reid_param_.inference_real_time_batch_size;
+            for (size_t i = 0; i < bboxes.size(); i += batch_size)
+            {
+                const int n = std::min(bboxes.size() - i, size_t(batch_size));
+                cv::Mat blob({n, 3, preprocess_param.height, preprocess_param.width}, CV_32F);
+                preprocess_crops(image, bboxes.begin() + i, bboxes.begin() + i + n, preprocess_param, blob.ptr<float>());
+                inference(net_real_time, blob, result);
+            }
+            return result;
+        }
+
+        std::vector<float> ReidCpuBackend::do_inference_offline(const std::vector<cv::Mat> &images)
+        {
+            std::vector<float> result;
+            const int batch_size = reid_param_.inference_offline_batch_size;
+            for (size_t i = 0; i < images.size(); i += batch_size)
+            {
+                const int n = std::min(images.size() - i, size_t(batch_size));
+                cv::Mat blob({n, 3, preprocess_param.height, preprocess_param.width}, CV_32F);
+                preprocess_images(images.begin() + i, images.begin() + i + n, preprocess_param, blob.ptr<float>());
+                inference(net_offline, blob, result);
+            }
+            return result;
+        }
+
+        void ReidCpuBackend::inference(cv::dnn::Net &net, const cv::Mat &blob, std::vector<float> &result)
+        {
+            net.setInput(blob);
+            cv::Mat feat = net.forward();
+            result.insert(result.end(), feat.ptr<float>(), feat.ptr<float>() + feat.total());
+        }
+    } // namespace reid
+} // namespace ptl
@@ -1,3 +1,12 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+#include <numeric>
+
+#include <faiss/utils/distances.h>
+#include <omp.h>
+
 #include "ptl_reid_cpp/reid_database.h"
 
 using idx_t = faiss::Index::idx_t;
@@ -5,85 +14,437 @@ namespace ptl
 {
     namespace reid
     {
-        int ReidDatabase::query_and_update(const std::vector<float> &feat_query, const cv::Mat &example_image, const geometry_msgs::Point &position)
+        void brute_force_search(const float *feat_query, const idx_t nq, const float *feat_base, const idx_t nb,
+                                const int feat_dimension, const idx_t k, float *distance, idx_t *index)
         {
-            int id = query(feat_query);
-            update(feat_query, id, example_image, position);
-            report_object_db();
-            return id;
+            std::vector<float> distance_all(nb);
+            std::vector<idx_t> order(nb);
+            const idx_t k_found = std::min(k, nb);
+            for (idx_t i = 0; i < nq; i++)
+            {
+                faiss::fvec_L2sqr_ny(distance_all.data(), feat_query + i * feat_dimension, feat_base, feat_dimension, nb);
+                std::iota(order.begin(), order.end(), 0);
+                std::partial_sort(order.begin(), order.begin() + k_found, order.end(),
+                                  [&distance_all](idx_t a, idx_t b) { return distance_all[a] < distance_all[b]; });
+                for (idx_t j = 0; j < k; j++)
+                {
+                    distance[i * k + j] = j < k_found ? distance_all[order[j]] : std::numeric_limits<float>::max();
+                    index[i * k + j] = j < k_found ? order[j] : -1;
+                }
+            }
         }
 
-        int ReidDatabase::query(const std::vector<float> &feat_query, bool need_report)
+        std::unique_ptr<faiss::IndexIVF> build_inverted_file(const std::vector<float> &feat, const std::vector<idx_t> &label,
+                                                             const DataBaseParam &db_param)
         {
-            if (object_db.empty())
+            const int d = db_param.feat_dimension;
+            const idx_t n = feat.size() / d;
+            const size_t nlist = std::max(size_t(1), size_t(n / db_param.nlist_ratio));
+            faiss::IndexFlatL2 *quantizer = new faiss::IndexFlatL2(d);
+            std::unique_ptr<faiss::IndexIVF> db;
+            if (db_param.inverted_file_type == "ivf_pq")
             {
-                return 0;
+                db.reset(new faiss::IndexIVFPQ(quantizer, d, nlist, db_param.pq_m, 8, faiss::METRIC_L2));
+            }
+            else if (db_param.inverted_file_type == "ivf_sq8")
+            {
+                db.reset(new faiss::IndexIVFScalarQuantizer(quantizer, d, nlist, faiss::ScalarQuantizer::QT_8bit, faiss::METRIC_L2));
+            }
+            else
+            {
+                if (db_param.inverted_file_type != "ivf_flat")
+                {
+                    std::cout << "Unknown inverted file type: " << db_param.inverted_file_type << ", use ivf_flat instead." << std::endl;
+                }
+                db.reset(new faiss::IndexIVFFlat(quantizer, d, nlist, faiss::METRIC_L2));
+            }
+            db->own_fields = true;
+            db->train(n, feat.data());
+            db->add_with_ids(n, feat.data(), label.data());
+            return db;
+        }
+
+        std::unique_ptr<faiss::Index> build_hnsw(const std::vector<float> &feat, const std::vector<idx_t> &label,
+                                                 const DataBaseParam &db_param)
+        {
+            //the graph keeps its own copy of the features, the labels are kept by the id map
+            faiss::IndexHNSWFlat *hnsw = new faiss::IndexHNSWFlat(db_param.feat_dimension, db_param.hnsw_m, faiss::METRIC_L2);
+            hnsw->hnsw.efConstruction = db_param.hnsw_ef_construction;
+            faiss::IndexIDMap *db = new faiss::IndexIDMap(hnsw);
+            db->own_fields = true;
+            set_hnsw_param(*db, db_param);
+            db->add_with_ids(label.size(), feat.data(), label.data());
+            return std::unique_ptr<faiss::Index>(db);
+        }
+
+        void set_hnsw_param(faiss::Index &db, const DataBaseParam &db_param)
+        {
+            faiss::IndexIDMap *db_id_map = dynamic_cast<faiss::IndexIDMap *>(&db);
+            faiss::IndexHNSW *hnsw = db_id_map == nullptr ? nullptr : dynamic_cast<faiss::IndexHNSW *>(db_id_map->index);
+            if (hnsw != nullptr)
+            {
+                hnsw->hnsw.efConstruction = db_param.hnsw_ef_construction;
+                hnsw->hnsw.efSearch = db_param.hnsw_ef_search;
+            }
+        }
+
+        std::unique_ptr<faiss::Index> build_large_db(const std::vector<float> &feat, const std::vector<idx_t> &label,
+                                                     const DataBaseParam &db_param)
+        {
+            if (db_param.large_db_type == "hnsw")
+            {
+                return build_hnsw(feat, label, db_param);
+            }
+            if (db_param.large_db_type != "ivf")
+            {
+                std::cout << "Unknown large database type: " << db_param.large_db_type << ", use ivf instead." << std::endl;
+            }
+            return build_inverted_file(feat, label, db_param);
+        }
+
+        void search_large_db(const faiss::Index &db, const DataBaseParam &db_param, const float *feat_store,
+                             const idx_t n, const float *feat_query, const idx_t k, float *distance, idx_t *index)
+        {
+            const faiss::IndexIVF *db_ivf = dynamic_cast<const faiss::IndexIVF *>(&db);
+            if (db_ivf != nullptr)
+            {
+                search_inverted_file(*db_ivf, db_param, feat_store, n, feat_query, k, distance, index);
             }
             else
             {
-                std::vector<idx_t> index;
-                std::vector<idx_t> index_fake(db_param_.find_first_k * feat_query.size() / db_param_.feat_dimension);
+                db.search(n, feat_query, k, distance, index);
+            }
+        }
 
-                std::vector<float> distance(db_param_.find_first_k * feat_query.size() / db_param_.feat_dimension);
-                //find the k nearest neighbour first
-                if (is_using_db_small)
+        void search_inverted_file(const faiss::IndexIVF &db, const DataBaseParam &db_param, const float *feat_store,
+                                  const idx_t n, const float *feat_query, const idx_t k, float *distance, idx_t *index)
+        {
+            if (db_param.inverted_file_type == "ivf_flat" || db_param.rerank_k <= k)
+            {
+                db.search(n, feat_query, k, distance, index);
+                return;
+            }
+
+            //take more candidates from the compressed inverted file, then re-rank them with the raw features
+            const idx_t k_candidate = db_param.rerank_k;
+            const int d = db_param.feat_dimension;
+            std::vector<float> distance_candidate(n * k_candidate);
+            std::vector<idx_t> index_candidate(n * k_candidate);
+            db.search(n, feat_query, k_candidate, distance_candidate.data(), index_candidate.data());
+
+            std::vector<std::pair<float, idx_t>> reranked;
+            for (idx_t i = 0; i < n; i++)
+            {
+                reranked.clear();
+                for (idx_t j = i * k_candidate; j < (i + 1) * k_candidate; j++)
                 {
-                    db_small.search(feat_query.size() / db_param_.feat_dimension, feat_query.data(),
-                                    db_param_.find_first_k, distance.data(), index_fake.data());
+                    if (index_candidate[j] < 0)
+                    {
+                        break;
+                    }
+                    reranked.emplace_back(faiss::fvec_L2sqr(feat_query + i * d, feat_store + index_candidate[j] * d, d),
+                                          index_candidate[j]);
                 }
-                else
+                const size_t k_found = std::min(size_t(k), reranked.size());
+                std::partial_sort(reranked.begin(), reranked.begin() + k_found, reranked.end());
+                for (idx_t j = 0; j < k; j++)
                 {
-                    db_large->search(feat_query.size() / db_param_.feat_dimension, feat_query.data(),
-                                     db_param_.find_first_k, distance.data(), index_fake.data());
+                    distance[i * k + j] = j < k_found ? reranked[j].first : std::numeric_limits<float>::max();
+                    index[i * k + j] = j < k_found ? reranked[j].second : -1;
                 }
-                convert_index(index_fake, index);
+            }
+        }
 
-                //get the id of this batch
-                std::vector<int> match_count(object_db.size() + 1, 0);
-                int match_id = -1;
-                int max_count = 0;
-                for (int i = 0; i < index.size() / db_param_.find_first_k; i++)
+        ReidDatabase::ReidDatabase(const DataBaseParam &db_param)
+            : db_param_(db_param), feat_arena(db_param.feat_dimension, int(db_param.max_feat_num_one_object))
+        {
+            if (!db_param_.snapshot_dir.empty())
+            {
+                snapshot.reset(new ReidSnapshot(db_param_.snapshot_dir, db_param_.snapshot_checkpoint_interval));
+                if (!snapshot->valid())
+                {
+                    snapshot.reset();
+                }
+                else if (snapshot->load(*this))
                 {
-                    int matched_db_id_for_this_query;
-                    if (distance[i * db_param_.find_first_k] < db_param_.same_id_threshold)
+                    report_object_db();
+                }
+
+                //the features replayed from the segment are inserted into a loaded HNSW graph
+                if (db_large != nullptr && db_param_.large_db_type == "hnsw")
+                {
+                    for (int s = 0; s < feat_arena.slab_num(); s++)
                     {
-                        match_count[index[i * db_param_.find_first_k]]++;
-                        matched_db_id_for_this_query = index[i * db_param_.find_first_k];
+                        add_to_db_large(s);
                     }
-                    else
+                }
+            }
+        }
+
+        int ReidDatabase::query_and_update(const std::vector<float> &feat_query, const cv::Mat &example_image, const geometry_msgs::Point &position,
+                                           const double time)
+        {
+            return query_and_update(std::vector<std::vector<float>>{feat_query}, std::vector<cv::Mat>{example_image},
+                                    std::vector<geometry_msgs::Point>{position}, std::vector<double>{time})[0];
+        }
+
+        std::vector<int> ReidDatabase::query_and_update(const std::vector<std::vector<float>> &feat_query, const std::vector<cv::Mat> &example_image,
+                                                        const std::vector<geometry_msgs::Point> &position, const std::vector<double> &time)
+        {
+            const int d = db_param_.feat_dimension;
+            const idx_t k = db_param_.find_first_k;
+            const bool use_filter = db_param_.max_walking_speed > 0;
+            if (db_param_.num_threads > 0)
+            {
+                //only affects the parallel regions of the calling thread, including the ones in faiss
+                omp_set_num_threads(db_param_.num_threads);
+            }
+            try_swap_db();
+
+            //with the spatial-temporal filter, an object with few reachable features only scans them exactly,
+            //the others search the whole gallery for more neighbours and drop the unreachable ones
+            //stale entries of db_large are dropped from the results too
+            const bool has_stale = num_feat_stale > 0 || !label_replaced.empty();
+            const idx_t k_search = use_filter || has_stale ? k * std::max(1, db_param_.spatial_overfetch) : k;
+            std::vector<bool> search_all(feat_query.size(), true);
+            for (int t = 0; t < feat_query.size(); t++)
+            {
+                if (use_filter && time[t] > 0 && !object_db.empty())
+                {
+                    std::vector<char> is_candidate;
+                    std::vector<int> slabs;
+                    idx_t feat_num_candidate = find_reachable(position[t], time[t], is_candidate, slabs);
+                    search_all[t] = db_large != nullptr && feat_num_candidate > db_param_.use_inverted_file_db_threshold;
+                }
+            }
+
+            //search the features of all the objects that need the whole gallery in one go
+            std::vector<idx_t> feat_offset(feat_query.size() + 1, 0), search_offset(feat_query.size() + 1, 0);
+            std::vector<float> feat_batch, feat_search;
+            for (int t = 0; t < feat_query.size(); t++)
+            {
+                const idx_t nq = feat_query[t].size() / d;
+                feat_offset[t + 1] = feat_offset[t] + nq;
+                feat_batch.insert(feat_batch.end(), feat_query[t].begin(), feat_query[t].begin() + nq * d);
+                search_offset[t + 1] = search_offset[t] + (search_all[t] ? nq : 0);
+                if (search_all[t])
+                {
+                    feat_search.insert(feat_search.end(), feat_query[t].begin(), feat_query[t].begin() + nq * d);
+                }
+            }
+            std::vector<float> distance_batch(search_offset.back() * k_search, std::numeric_limits<float>::max());
+            std::vector<idx_t> index_batch(search_offset.back() * k_search, -1);
+            if (!object_db.empty() && search_offset.back() > 0)
+            {
+                search_feature_db(search_offset.back(), feat_search.data(), k_search, distance_batch.data(), index_batch.data());
+            }
+
+            //assign the ids one object after another, as if each object was queried and updated alone,
+            //so the features added by the earlier objects of this batch are also searched exactly
+            std::vector<int> ids;
+            std::vector<idx_t> label_batch;
+            std::unordered_set<idx_t> label_batch_set;
+            for (int t = 0; t < feat_query.size(); t++)
+            {
+                const idx_t nq = feat_offset[t + 1] - feat_offset[t];
+                if (nq == 0)
+                {
+                    //nothing to query with
+                    ids.push_back(-1);
+                    continue;
+                }
+                const float *feat = feat_batch.data() + feat_offset[t] * d;
+
+                //the reachable objects are found with the database updated by the earlier objects of this batch
+                std::vector<char> is_candidate;
+                std::vector<int> slabs;
+                if (use_filter && time[t] > 0 && !object_db.empty())
+                {
+                    find_reachable(position[t], time[t], is_candidate, slabs);
+                }
+
+                std::vector<float> distance(nq * k);
+                std::vector<idx_t> index_fake(nq * k);
+                if (search_all[t])
+                {
+                    //the features changed by this batch and the replaced features are not up to date in the search results,
+                    //they are searched exactly instead
+                    select_result(distance_batch.data() + search_offset[t] * k_search, index_batch.data() + search_offset[t] * k_search,
+                                  nq, k_search, is_candidate, label_batch_set, distance.data(), index_fake.data());
+                    std::vector<idx_t> label_candidate;
+                    std::unordered_set<idx_t> label_checked;
+                    //by pointer, so the vectors are not copied for every track
+                    for (const std::vector<idx_t> *labels : {&label_batch, &label_replaced})
                     {
-                        // no correct matched object found
-                        match_count[object_db.size()]++;
-                        matched_db_id_for_this_query = object_db.size();
+                        for (auto l : *labels)
+                        {
+                            int owner = feat_arena.owner(l);
+                            if (owner >= 0 && (is_candidate.empty() || is_candidate[owner]) && label_checked.insert(l).second)
+                            {
+                                label_candidate.push_back(l);
+                            }
+                        }
                     }
+                    merge_exact_search(feat, nq, label_candidate, distance.data(), index_fake.data());
+                }
+                else
+                {
+                    //the slabs already hold the features added by this batch
+                    feat_arena.search_slabs(feat, nq, k, slabs, distance.data(), index_fake.data());
+                }
 
-                    if (match_count[matched_db_id_for_this_query] > max_count)
+                int id = 0;
+                if (!object_db.empty())
+                {
+                    std::vector<idx_t> index;
+                    convert_index(index_fake, index);
+                    id = vote_id(index, distance);
+                }
+
+                std::vector<idx_t> label_update;
+                update(feat_query[t], id, example_image[t], position[t], time[t], label_update);
+                for (auto l : label_update)
+                {
+                    if (label_batch_set.insert(l).second)
                     {
-                        match_id = matched_db_id_for_this_query;
-                        max_count = match_count[matched_db_id_for_this_query];
+                        label_batch.push_back(l);
                     }
                 }
+                ids.push_back(id);
+            }
 
-                if (need_report)
+            //apply the retention policies at the latest time of this batch, the ids returned for this batch stay alive
+            evict_objects(time.empty() ? 0 : *std::max_element(time.begin(), time.end()), ids);
+            report_object_db();
+            return ids;
+        }
+
+        idx_t ReidDatabase::find_reachable(const geometry_msgs::Point &position, const double time,
+                                           std::vector<char> &is_candidate, std::vector<int> &slabs)
+        {
+            idx_t feat_num_candidate = 0;
+            is_candidate.assign(object_db.size(), 0);
+            slabs.clear();
+            for (const auto &ob : object_db)
+            {
+                if (ob.is_evicted)
                 {
-                    report_query(index, distance);
+                    continue;
                 }
+                //an object that has never been seen with a time stamp is always reachable
+                const double distance = std::hypot(ob.pos.x - position.x, ob.pos.y - position.y);
+                const double distance_max = db_param_.max_walking_speed * std::abs(time - ob.last_seen) + db_param_.spatial_slack;
+                if (ob.last_seen <= 0 || distance <= distance_max)
+                {
+                    is_candidate[ob.id] = 1;
+                    slabs.push_back(ob.slab);
+                    feat_num_candidate += ob.feat_num;
+                }
+            }
+            return feat_num_candidate;
+        }
 
-                std::cout << "\033[32m"
-                          << "id: " << match_id << " , batch: " << max_count << "/"
-                          << feat_query.size() / db_param_.feat_dimension << " = " << 1.0 * max_count / (feat_query.size() / db_param_.feat_dimension)
-                          << "\033[0m" << std::endl;
+        void ReidDatabase::select_result(const float *distance_all, const idx_t *index_all, const idx_t n, const idx_t k_all,
+                                         const std::vector<char> &is_candidate, const std::unordered_set<idx_t> &label_excluded,
+                                         float *distance, idx_t *index)
+        {
+            const idx_t k = db_param_.find_first_k;
+            for (idx_t i = 0; i < n; i++)
+            {
+                idx_t j_out = i * k;
+                for (idx_t j = i * k_all; j < (i + 1) * k_all && j_out < (i + 1) * k; j++)
+                {
+                    if (is_valid_result(index_all[j]) && label_excluded.count(index_all[j]) == 0 &&
+                        (is_candidate.empty() || is_candidate[feat_arena.owner(index_all[j])]))
+                    {
+                        distance[j_out] = distance_all[j];
+                        index[j_out] = index_all[j];
+                        j_out++;
+                    }
+                }
+                for (; j_out < (i + 1) * k; j_out++)
+                {
+                    distance[j_out] = std::numeric_limits<float>::max();
+                    index[j_out] = -1;
+                }
+            }
+        }
+
+        int ReidDatabase::vote_id(const std::vector<idx_t> &index, const std::vector<float> &distance, bool need_report)
+        {
+            //get the id of this batch
+            std::vector<int> match_count(object_db.size() + 1, 0);
+            int match_id = -1;
+            int max_count = 0;
+            for (int i = 0; i < index.size() / db_param_.find_first_k; i++)
+            {
+                int matched_db_id_for_this_query;
+                if (distance[i * db_param_.find_first_k] < db_param_.same_id_threshold)
+                {
+                    match_count[index[i * db_param_.find_first_k]]++;
+                    matched_db_id_for_this_query = index[i * db_param_.find_first_k];
+                }
+                else
+                {
+                    // no correct matched object found
+                    match_count[object_db.size()]++;
+                    matched_db_id_for_this_query = object_db.size();
+                }
 
-                if (1.0 * max_count / (feat_query.size() / db_param_.feat_dimension) < db_param_.batch_ratio)
+                if (match_count[matched_db_id_for_this_query] > max_count)
                 {
-                    std::cout << db_param_.batch_ratio << std::endl;
-                    std::cout << "\033[31m"
-                              << "Failed the batch test! This is an unknown object."
-                              << "\033[0m" << std::endl;
-                    match_id = object_db.size();
+                    match_id = matched_db_id_for_this_query;
+                    max_count = match_count[matched_db_id_for_this_query];
                 }
+            }
 
-                return match_id;
+            if (need_report)
+            {
+                report_query(index, distance);
+            }
+
+            std::cout << "\033[32m"
+                      << "id: " << match_id << " , batch: " << max_count << "/"
+                      << index.size() / db_param_.find_first_k << " = " << 1.0 * max_count / (index.size() / db_param_.find_first_k)
+                      << "\033[0m" << std::endl;
+
+            if (1.0 * max_count / (index.size() / db_param_.find_first_k) < db_param_.batch_ratio)
+            {
+                std::cout << db_param_.batch_ratio << std::endl;
+                std::cout << "\033[31m"
+                          << "Failed the batch test! This is an unknown object."
+                          << "\033[0m" << std::endl;
+                match_id = object_db.size();
+            }
+
+            return match_id;
+        }
+
+        void ReidDatabase::merge_exact_search(const float *feat, const idx_t n, const std::vector<idx_t> &label,
+                                              float *distance, idx_t *index)
+        {
+            const idx_t k = db_param_.find_first_k;
+            for (idx_t i = 0; i < n; i++)
+            {
+                float *distance_i = distance + i * k;
+                idx_t *index_i = index + i * k;
+                for (auto l : label)
+                {
+                    float dist = faiss::fvec_L2sqr(feat + i * db_param_.feat_dimension, feat_arena.feature(l), db_param_.feat_dimension);
+                    if (dist >= distance_i[k - 1])
+                    {
+                        continue;
+                    }
+                    //insert into the sorted result list
+                    idx_t j = k - 1;
+                    for (; j > 0 && distance_i[j - 1] > dist; j--)
+                    {
+                        distance_i[j] = distance_i[j - 1];
+                        index_i[j] = index_i[j - 1];
+                    }
+                    distance_i[j] = dist;
+                    index_i[j] = l;
+                }
             }
         }
 
@@ -101,117 +462,441 @@ namespace ptl
             }
         }
 
-        void ReidDatabase::update(const std::vector<float> &feat_query, int id, const cv::Mat &example_image, const geometry_msgs::Point &position)
+        void ReidDatabase::update(const std::vector<float> &feat_query, int id, const cv::Mat &example_image, const geometry_msgs::Point &position,
+                                  const double time, std::vector<idx_t> &label_update)
         {
-            std::vector<float> feat_update;
-            //update object database and get the feature that will be added to the feature database
-            update_object_db(feat_query, feat_update, id, example_image, position);
+            //update object database, the features that pass the similarity check are added to the feature arena
+            int feat_num_update = update_object_db(feat_query, id, example_image, position, time, label_update);
 
             //updat feature database
-            update_feature_db(feat_update, id);
+            update_feature_db(feat_num_update, id);
+
+            //persist the changes, the segment is compacted into a checkpoint once in a while
+            if (snapshot != nullptr)
+            {
+                snapshot->log_position(id, object_db[id].pos, object_db[id].last_seen);
+                snapshot->flush();
+                if (snapshot->need_checkpoint())
+                {
+                    snapshot->checkpoint(*this);
+                }
+            }
         }
 
-        void ReidDatabase::update_object_db(const std::vector<float> &feat_query, std::vector<float> &feat_update, const int id,
-                                            const cv::Mat &example_image, const geometry_msgs::Point &position)
+        int ReidDatabase::update_object_db(const std::vector<float> &feat_query, const int id, const cv::Mat &example_image,
+                                           const geometry_msgs::Point &position, const double time, std::vector<idx_t> &label_update)
         {
-            feat_update.clear();
-            for (int i = 0; i < feat_query.size() / db_param_.feat_dimension; ++i)
+            const int d = db_param_.feat_dimension;
+            const int n = feat_query.size() / d;
+            if (n == 0)
+            {
+                return 0;
+            }
+
+            //update position first
+            if (id == max_id)
             {
-                std::vector<float> feat(feat_query.begin() + db_param_.feat_dimension * i,
-                                        feat_query.begin() + db_param_.feat_dimension * (i + 1));
-                //update position first
-                if (i == 0 && id == max_id)
+                //create new object first, with its own slab in the feature arena
+                object_db.emplace_back(max_id, example_image, position, feat_arena.allocate(max_id));
+                if (snapshot != nullptr)
                 {
-                    //create new object first
-                    object_db.emplace_back(max_id, example_image, position);
-                    max_id++;
+                    snapshot->log_new_object(max_id, object_db.back().slab, position, example_image);
                 }
-                else
+                max_id++;
+            }
+            ObjectType &ob = object_db[id];
+            ob.update_pos(position, time);
+
+            //the similarity check of all the features against the slab is done in parallel,
+            //then the features are inserted one by one, only the slots written by this batch are checked again
+            const int slab_size = feat_arena.size(ob.slab);
+            std::vector<float> distance_slab(size_t(n) * slab_size);
+            if (ob.feat_num + n > db_param_.sim_check_start_threshold)
+            {
+                feat_arena.distance_matrix(ob.slab, feat_query.data(), n, distance_slab.data());
+            }
+            std::vector<char> slot_written(feat_arena.slab_capacity(), 0);
+            auto min_distance = [&](const int i) {
+                const float *feat = feat_query.data() + size_t(d) * i;
+                float distance = std::numeric_limits<float>::max();
+                for (int j = 0; j < feat_arena.size(ob.slab); j++)
                 {
-                    //update position
-                    object_db[id].update_pos(position);
+                    distance = std::min(distance, j < slab_size && !slot_written[j]
+                                                      ? distance_slab[size_t(i) * slab_size + j]
+                                                      : faiss::fvec_L2sqr(feat, feat_arena.feature(feat_arena.label(ob.slab, j)), d));
                 }
+                return distance;
+            };
+
+            int feat_num_update = 0;
+            for (int i = 0; i < n; ++i)
+            {
+                const float *feat = feat_query.data() + size_t(d) * i;
 
                 //update object local feature database
-                if (object_db[id].feat_num < db_param_.sim_check_start_threshold)
+                if (ob.feat_num < db_param_.sim_check_start_threshold)
                 {
-                    object_db[id].db.add(1, feat.data());
-                    object_db[id].feat_num++;
-                    feat_update.insert(feat_update.end(), feat.begin(), feat.end());
+                    idx_t label = feat_arena.add(ob.slab, feat);
+                    if (label >= 0)
+                    {
+                        slot_written[label - feat_arena.label(ob.slab, 0)] = 1;
+                        ob.feat_num++;
+                        feat_num_update++;
+                        label_update.push_back(label);
+                        if (snapshot != nullptr)
+                        {
+                            snapshot->log_feature(ob.slab, feat, db_param_.feat_dimension);
+                        }
+                    }
                 }
                 else
                 {
                     //start similiarity check
                     //checking the similiarity of local database, if the similarity is too high,
                     //we won't add this feature to database to ensure variety
-                    std::vector<idx_t> index(1);
-                    std::vector<float> distance(1);
-                    object_db[id].db.search(1, feat.data(), 1, distance.data(), index.data());
+                    float distance = min_distance(i);
 
                     //pass the sim check， then we add it to the database
-                    if (distance[0] > db_param_.similarity_test_threshold && object_db[id].feat_num <= db_param_.max_feat_num_one_object)
+                    if (distance <= db_param_.similarity_test_threshold)
+                    {
+                        continue;
+                    }
+                    idx_t label = feat_arena.add(ob.slab, feat);
+                    if (label >= 0)
+                    {
+                        slot_written[label - feat_arena.label(ob.slab, 0)] = 1;
+                        ob.feat_num++;
+                        feat_num_update++;
+                        label_update.push_back(label);
+                        if (snapshot != nullptr)
+                        {
+                            snapshot->log_feature(ob.slab, feat, db_param_.feat_dimension);
+                        }
+                    }
+                    else if (db_param_.diverse_feature_eviction)
                     {
-                        object_db[id].db.add(1, feat.data());
-                        object_db[id].feat_num++;
-                        feat_update.insert(feat_update.end(), feat.begin(), feat.end());
+                        //the slab is full, keep the new feature only if it adds more variety than the most redundant one
+                        float nn_distance;
+                        int redundant = feat_arena.most_redundant(ob.slab, nn_distance);
+                        if (distance > nn_distance)
+                        {
+                            label = feat_arena.label(ob.slab, redundant);
+                            slot_written[redundant] = 1;
+                            replace_feature(label, feat);
+                            label_update.push_back(label);
+                            if (snapshot != nullptr)
+                            {
+                                snapshot->log_replace_feature(label, feat, db_param_.feat_dimension);
+                            }
+                        }
                     }
                 }
             }
+            return feat_num_update;
         }
 
-        void ReidDatabase::update_feature_db(const std::vector<float> &feat_update, const int id)
+        void ReidDatabase::update_feature_db(const int feat_num_update, const int id)
         {
-            //save the features
-            feat_all.insert(feat_all.end(), feat_update.begin(), feat_update.end());
-            std::vector<idx_t> ids(feat_update.size() / db_param_.feat_dimension, id);
-            id_all.insert(id_all.end(), ids.begin(), ids.end());
-            num_feat += feat_update.size() / db_param_.feat_dimension;
+            if (feat_num_update == 0)
+            {
+                return;
+            }
+            num_feat += feat_num_update;
 
-            // database mangement strategy
-            // small feature database use Brute-force search
-            // large feature database use Inverted file to store teh database
-            // when the number of features became two times of the number when we build the inverted file, we rebuild the inverted file
+            //the HNSW graph takes new features directly
+            if (db_param_.large_db_type == "hnsw" && db_large != nullptr)
+            {
+                add_to_db_large(object_db[id].slab);
+            }
+            maybe_start_building_db();
+        }
 
-            if (is_using_db_small)
+        void ReidDatabase::replace_feature(const idx_t label, const float *feat)
+        {
+            feat_arena.replace(label, feat);
+            if (db_large != nullptr || is_building_db)
+            {
+                label_replaced.push_back(label);
+                label_replaced_count[label]++;
+                num_feat_stale++;
+                num_feat_stale_in_building += is_building_db ? 1 : 0;
+            }
+        }
+
+        void ReidDatabase::evict_objects(const double time_now, const std::vector<int> &keep_ids)
+        {
+            std::vector<int> evicted;
+            std::vector<const ObjectType *> alive;
+            std::vector<char> is_kept(object_db.size(), 0);
+            for (auto id : keep_ids)
+            {
+                if (id >= 0 && id < object_db.size())
+                {
+                    is_kept[id] = 1;
+                }
+            }
+            for (const auto &ob : object_db)
             {
-                if (num_feat > db_param_.use_inverted_file_db_threshold)
+                if (ob.is_evicted)
+                {
+                    continue;
+                }
+                if (!is_kept[ob.id] && db_param_.identity_ttl > 0 && time_now > 0 && ob.last_seen > 0 && time_now - ob.last_seen > db_param_.identity_ttl)
                 {
-                    //build a new larger database
-                    db_large = new faiss::IndexIVFFlat(&db_small, db_param_.feat_dimension, size_t(num_feat / db_param_.nlist_ratio), faiss::METRIC_INNER_PRODUCT);
-                    db_large->train(num_feat, feat_all.data()); //TODO this step might perform asychronously
-                    db_large->add(num_feat, feat_all.data());
-                    is_using_db_small = false;
-                    num_feat_when_building_db = num_feat;
+                    evicted.push_back(ob.id);
                 }
                 else
                 {
-                    db_small.add(feat_update.size() / db_param_.feat_dimension, feat_update.data());
+                    alive.push_back(&ob);
                 }
             }
+
+            //least recently seen first, the objects without time stamp are the oldest
+            //the kept objects count towards the limit, but are not evicted even if the limit can not be met without them
+            if (db_param_.max_identity_num > 0 && alive.size() > db_param_.max_identity_num)
+            {
+                std::stable_sort(alive.begin(), alive.end(), [](const ObjectType *a, const ObjectType *b) { return a->last_seen < b->last_seen; });
+                size_t evict_num = alive.size() - db_param_.max_identity_num;
+                for (int i = 0; i < alive.size() && evict_num > 0; i++)
+                {
+                    if (!is_kept[alive[i]->id])
+                    {
+                        evicted.push_back(alive[i]->id);
+                        evict_num--;
+                    }
+                }
+            }
+
+            for (auto id : evicted)
+            {
+                std::cout << "Evict object " << id << " from the reid database." << std::endl;
+                evict_object(id);
+                if (snapshot != nullptr)
+                {
+                    snapshot->log_evict_object(id);
+                }
+            }
+            if (!evicted.empty())
+            {
+                maybe_start_building_db();
+            }
+        }
+
+        void ReidDatabase::evict_object(const int id)
+        {
+            ObjectType &ob = object_db[id];
+            ob.is_evicted = true;
+            ob.example_image.release();
+            num_feat -= ob.feat_num;
+            ob.feat_num = 0;
+
+            //the slab can not be reused while db_large (or the one being built) may hold its labels
+            if (db_large != nullptr || is_building_db)
+            {
+                num_feat_stale += ob.slab < slab_num_in_db_large.size() ? slab_num_in_db_large[ob.slab] : 0;
+                //the index being built holds the entries of the slab in its snapshot, which go stale once it is swapped in
+                if (is_building_db)
+                {
+                    num_feat_stale_in_building += ob.slab < slab_num_when_building_db.size() ? slab_num_when_building_db[ob.slab] : 0;
+                }
+                slab_released.push_back(ob.slab);
+                feat_arena.release(ob.slab);
+            }
             else
             {
-                //rebuild a new larger database when the current inverted file become twice the size when it was built to ensure
-                //efficiency in searching
-                if (num_feat / num_feat_when_building_db > 2)
+                feat_arena.release(ob.slab);
+                feat_arena.recycle(ob.slab);
+            }
+        }
+
+        void ReidDatabase::maybe_start_building_db()
+        {
+            if (is_building_db)
+            {
+                return;
+            }
+
+            //compaction
+            //a small database goes back to brute-force search, a large one rebuilds db_large without the stale entries
+            if (db_large != nullptr && num_feat_stale > db_param_.compaction_stale_ratio * num_feat_in_db_large)
+            {
+                if (num_feat <= db_param_.use_inverted_file_db_threshold)
                 {
-                    db_large = new faiss::IndexIVFFlat(&db_small, db_param_.feat_dimension, size_t(num_feat / db_param_.nlist_ratio), faiss::METRIC_INNER_PRODUCT);
-                    db_large->train(num_feat, feat_all.data()); //TODO this step might perform asychronously
-                    db_large->add(num_feat, feat_all.data());
-                    num_feat_when_building_db = num_feat;
+                    std::cout << "Drop the large database, " << num_feat << " features remain in the brute-force database." << std::endl;
+                    drop_db_large();
                 }
                 else
                 {
-                    db_large->add(feat_update.size() / db_param_.feat_dimension, feat_update.data());
+                    start_building_db();
                 }
+                return;
+            }
+
+            // database mangement strategy
+            // small feature database use Brute-force search
+            // large feature database use Inverted file (or HNSW graph) to store the database
+            // when the number of features became two times of the number when we build the inverted file, we rebuild the inverted file
+            // the HNSW graph is only rebuilt by compaction
+            // db_large is built in the background, new features stay in the delta database until the new one is swapped in
+            if (num_feat > db_param_.use_inverted_file_db_threshold &&
+                (db_large == nullptr || (db_param_.large_db_type != "hnsw" && num_feat >= 2 * num_feat_in_db_large)))
+            {
+                start_building_db();
             }
         }
 
+        void ReidDatabase::search_feature_db(const idx_t n, const float *feat, const idx_t k, float *distance, idx_t *index)
+        {
+            try_swap_db();
+            if (db_large == nullptr)
+            {
+                feat_arena.search(feat, n, k, slab_num_in_db_large, distance, index);
+                return;
+            }
+
+            std::vector<float> distance_large(n * k), distance_delta(n * k);
+            std::vector<idx_t> index_large(n * k), index_delta(n * k);
+            search_large_db(*db_large, db_param_, feat_arena.data(), n, feat, k, distance_large.data(), index_large.data());
+            feat_arena.search(feat, n, k, slab_num_in_db_large, distance_delta.data(), index_delta.data());
+
+            //merge the two sorted result lists of each query, both use the labels of the feature arena
+            const float max_distance = std::numeric_limits<float>::max();
+            for (idx_t i = 0; i < n; i++)
+            {
+                idx_t i_large = i * k, i_delta = i * k;
+                for (idx_t j = i * k; j < (i + 1) * k; j++)
+                {
+                    float d_large = index_large[i_large] < 0 ? max_distance : distance_large[i_large];
+                    float d_delta = index_delta[i_delta] < 0 ? max_distance : distance_delta[i_delta];
+                    if (d_large <= d_delta)
+                    {
+                        distance[j] = d_large;
+                        index[j] = index_large[i_large];
+                        i_large++;
+                    }
+                    else
+                    {
+                        distance[j] = d_delta;
+                        index[j] = index_delta[i_delta];
+                        i_delta++;
+                    }
+                }
+            }
+        }
+
+        void ReidDatabase::drop_db_large()
+        {
+            db_large.reset();
+            slab_num_in_db_large.clear();
+            num_feat_in_db_large = 0;
+            num_feat_stale = 0;
+            label_replaced.clear();
+            label_replaced_count.clear();
+            for (auto s : slab_released)
+            {
+                feat_arena.recycle(s);
+            }
+            slab_released.clear();
+        }
+
+        void ReidDatabase::start_building_db()
+        {
+            std::cout << "Start building the " << (db_param_.large_db_type == "hnsw" ? "hnsw" : db_param_.inverted_file_type) << " database with "
+                      << num_feat << " features in the background." << std::endl;
+            num_feat_when_building_db = num_feat;
+            num_feat_stale_in_building = 0;
+            label_replaced_when_building = label_replaced.size();
+            slab_released_when_building = slab_released.size();
+            slab_num_when_building_db.resize(feat_arena.slab_num());
+            for (int s = 0; s < feat_arena.slab_num(); s++)
+            {
+                slab_num_when_building_db[s] = feat_arena.size(s);
+            }
+
+            //the arena may grow while building, so the background thread works on a copy of the features
+            std::vector<float> feat;
+            std::vector<idx_t> label;
+            feat_arena.snapshot(feat, label);
+            db_large_building = std::async(std::launch::async, build_large_db, std::move(feat), std::move(label), db_param_);
+            is_building_db = true;
+            num_db_large_build++;
+        }
+
+        void ReidDatabase::try_swap_db()
+        {
+            if (!is_building_db ||
+                db_large_building.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            {
+                return;
+            }
+
+            //the old inverted file is released here
+            //the features added after the snapshot remain in the delta database
+            db_large = db_large_building.get();
+            num_feat_in_db_large = num_feat_when_building_db;
+            slab_num_in_db_large = slab_num_when_building_db;
+            is_building_db = false;
+            num_db_large_swap++;
+
+            //the entries that went stale before the snapshot are not in the new db_large, only those since then count
+            num_feat_stale = num_feat_stale_in_building;
+            for (size_t i = 0; i < label_replaced_when_building; i++)
+            {
+                if (--label_replaced_count[label_replaced[i]] == 0)
+                {
+                    label_replaced_count.erase(label_replaced[i]);
+                }
+            }
+            label_replaced.erase(label_replaced.begin(), label_replaced.begin() + label_replaced_when_building);
+            for (size_t i = 0; i < slab_released_when_building; i++)
+            {
+                feat_arena.recycle(slab_released[i]);
+            }
+            slab_released.erase(slab_released.begin(), slab_released.begin() + slab_released_when_building);
+
+            //the features added while building the graph are inserted now, so the delta database stays empty
+            if (db_param_.large_db_type == "hnsw")
+            {
+                for (int s = 0; s < feat_arena.slab_num(); s++)
+                {
+                    add_to_db_large(s);
+                }
+            }
+            std::cout << "Swap in the large database with " << num_feat_in_db_large << " features, "
+                      << num_feat - num_feat_in_db_large << " features in the delta database." << std::endl;
+        }
+
+        void ReidDatabase::add_to_db_large(const int slab)
+        {
+            if (slab >= slab_num_in_db_large.size())
+            {
+                slab_num_in_db_large.resize(slab + 1, 0);
+            }
+            const int start = slab_num_in_db_large[slab];
+            const int n = feat_arena.size(slab) - start;
+            if (n <= 0)
+            {
+                return;
+            }
+            std::vector<idx_t> label(n);
+            for (int j = 0; j < n; j++)
+            {
+                label[j] = feat_arena.label(slab, start + j);
+            }
+            db_large->add_with_ids(n, feat_arena.feature(label[0]), label.data());
+            slab_num_in_db_large[slab] += n;
+            num_feat_in_db_large += n;
+        }
+
         void ReidDatabase::report_object_db()
         {
             std::cout << "*****Reid Database Report*****" << std::endl;
             for (const auto ob : object_db)
             {
-                std::cout << "id: " << ob.id << " | db num: " << ob.feat_num << std::endl;
+                if (!ob.is_evicted)
+                {
+                    std::cout << "id: " << ob.id << " | db num: " << ob.feat_num << std::endl;
+                }
             }
             std::cout << "***Reid Database Report Done***" << std::endl;
             std::cout << std::endl;
@@ -222,7 +907,8 @@ namespace ptl
             index.clear();
             for (auto idf : index_fake)
             {
-                index.push_back(id_all[idf]);
+                //faiss returns -1 when there are fewer than k features in the database, an evicted object has no owner either
+                index.push_back(idf < 0 ? -1 : feat_arena.owner(idf));
             }
         }
     } // namespace reid
@@ -0,0 +1,70 @@
+#include <algorithm>
+#include <cmath>
+
+#include "ptl_reid_cpp/reid_preprocess.h"
+
+namespace ptl
+{
+    namespace reid
+    {
+        void preprocess_crop(const cv::Mat &image, const cv::Rect &roi, const PreprocessParam &param, float *output)
+        {
+            const cv::Rect crop = roi & cv::Rect(0, 0, image.cols, image.rows);
+            const size_t plane = size_t(param.width) * param.height;
+            if (crop.empty())
+            {
+                std::fill(output, output + 3 * plane, 0.f);
+                return;
+            }
+
+            //source column of each output column, the same rounding as cv::resize with cv::INTER_NEAREST
+            const double scale_x = 1. / (double(param.width) / crop.width);
+            const double scale_y = 1. / (double(param.height) / crop.height);
+            std::vector<int> x_offset(param.width);
+            for (int x = 0; x < param.width; x++)
+            {
+                x_offset[x] = 3 * (crop.x + std::min(int(std::floor(x * scale_x)), crop.width - 1));
+            }
+
+            //bgr in, rgb planes out
+            const float scale[3] = {1.f / param.std[0], 1.f / param.std[1], 1.f / param.std[2]};
+            float *r = output, *g = output + plane, *b = output + 2 * plane;
+            for (int y = 0; y < param.height; y++)
+            {
+                const uchar *row = image.ptr<uchar>(crop.y + std::min(int(std::floor(y * scale_y)), crop.height - 1));
+                for (int x = 0; x < param.width; x++)
+                {
+                    const uchar *pixel = row + x_offset[x];
+                    *r++ = (pixel[2] - param.mean[0]) * scale[0];
+                    *g++ = (pixel[1] - param.mean[1]) * scale[1];
+                    *b++ = (pixel[0] - param.mean[2]) * scale[2];
+                }
+            }
+        }
+
+        void preprocess_crops(const cv::Mat &image, std::vector<cv::Rect2d>::const_iterator bboxes_begin,
+                              std::vector<cv::Rect2d>::const_iterator bboxes_end, const PreprocessParam &param, float *output)
+        {
+            const size_t input_size = 3 * size_t(param.width) * param.height;
+            cv::parallel_for_(cv::Range(0, bboxes_end - bboxes_begin), [&](const cv::Range &range) {
+                for (int i = range.start; i < range.end; i++)
+                {
+                    preprocess_crop(image, cv::Rect(*(bboxes_begin + i)), param, output + i * input_size);
+                }
+            });
+        }
+
+        void preprocess_images(std::vector<cv::Mat>::const_iterator image_begin, std::vector<cv::Mat>::const_iterator image_end,
+                               const PreprocessParam &param, float *output)
+        {
+            const size_t input_size = 3 * size_t(param.width) * param.height;
+            cv::parallel_for_(cv::Range(0, image_end - image_begin), [&](const cv::Range &range) {
+                for (int i = range.start; i < range.end; i++)
+                {
+                    const cv::Mat &image = *(image_begin + i);
+                    preprocess_crop(image, cv::Rect(0, 0, image.cols, image.rows), param, output + i * input_size);
+                }
+            });
+        }
+    } // namespace reid
+} // namespace ptl
@@ -0,0 +1,665 @@
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <vector>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <faiss/index_io.h>
+
+#include "ptl_reid_cpp/reid_database.h"
+#include "ptl_reid_cpp/reid_snapshot.h"
+
+namespace ptl
+{
+    namespace reid
+    {
+        namespace
+        {
+            const char checkpoint_magic[8] = {'P', 'T', 'L', 'R', 'E', 'I', 'D', 'C'};
+            const char segment_magic[8] = {'P', 'T', 'L', 'R', 'E', 'I', 'D', 'S'};
+            const uint32_t snapshot_version = 4;
+            const size_t feat_alignment = 64;
+
+            enum RecordType : uint32_t
+            {
+                RECORD_NEW_OBJECT = 1,
+                RECORD_FEATURE = 2,
+                RECORD_POSITION = 3,
+                RECORD_REPLACE_FEATURE = 4,
+                RECORD_EVICT_OBJECT = 5
+            };
+
+            struct CheckpointHeader
+            {
+                char magic[8];
+                uint32_t version;
+                uint32_t seq;
+                int32_t feat_dimension;
+                int32_t slab_capacity;
+                int32_t slab_num;
+                int32_t object_num;
+                int32_t max_id;
+                int32_t has_inverted_file;
+                int64_t num_feat_in_db_large;
+                int64_t num_feat_stale;     // stale entries of the inverted file, see ReidDatabase
+                int32_t label_replaced_num;
+                int32_t slab_released_num;
+                uint64_t feat_offset; // offset of the feature arena in the file
+            };
+
+            struct SegmentHeader
+            {
+                char magic[8];
+                uint32_t version;
+                uint32_t checkpoint_seq;
+            };
+
+            // read-only memory mapping of a whole file
+            class MappedFile
+            {
+            public:
+                explicit MappedFile(const std::string &path)
+                {
+                    int fd = open(path.c_str(), O_RDONLY);
+                    if (fd < 0)
+                    {
+                        return;
+                    }
+                    struct stat st;
+                    if (fstat(fd, &st) == 0 && st.st_size > 0)
+                    {
+                        void *p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+                        if (p != MAP_FAILED)
+                        {
+                            data_ = static_cast<const char *>(p);
+                            size_ = st.st_size;
+                        }
+                    }
+                    close(fd);
+                }
+
+                ~MappedFile()
+                {
+                    if (data_ != nullptr)
+                    {
+                        munmap(const_cast<char *>(data_), size_);
+                    }
+                }
+
+                MappedFile(const MappedFile &) = delete;
+                MappedFile &operator=(const MappedFile &) = delete;
+
+                const char *data() const { return data_; }
+                size_t size() const { return size_; }
+                bool valid() const { return data_ != nullptr; }
+
+            private:
+                const char *data_ = nullptr;
+                size_t size_ = 0;
+            };
+
+            // sequential reader over a memory range, it fails instead of reading past the end
+            class MappedReader
+            {
+            public:
+                MappedReader(const char *begin, const size_t size) : begin_(begin), p_(begin), end_(begin + size) {}
+
+                template <typename T>
+                bool read(T &value)
+                {
+                    if (size_t(end_ - p_) < sizeof(T))
+                    {
+                        return false;
+                    }
+                    std::memcpy(&value, p_, sizeof(T));
+                    p_ += sizeof(T);
+                    return true;
+                }
+
+                const char *take(const size_t n)
+                {
+                    if (size_t(end_ - p_) < n)
+                    {
+                        return nullptr;
+                    }
+                    const char *p = p_;
+                    p_ += n;
+                    return p;
+                }
+
+                bool read_point(geometry_msgs::Point &pos)
+                {
+                    return read(pos.x) && read(pos.y) && read(pos.z);
+                }
+
+                bool read_image(cv::Mat &img)
+                {
+                    int32_t rows, cols, type;
+                    if (!read(rows) || !read(cols) || !read(type) || rows < 0 || cols < 0)
+                    {
+                        return false;
+                    }
+                    if (rows == 0 || cols == 0)
+                    {
+                        img = cv::Mat();
+                        return true;
+                    }
+                    //a torn or corrupt file may hold any type and size, check them before allocating the image
+                    //the example images are all 8-bit bgr
+                    if (type != CV_8UC3)
+                    {
+                        return false;
+                    }
+                    const uint64_t bytes = uint64_t(rows) * uint64_t(cols) * 3;
+                    if (bytes > remaining())
+                    {
+                        return false;
+                    }
+                    const char *p = take(bytes);
+                    cv::Mat img_mapped(rows, cols, type);
+                    std::memcpy(img_mapped.data, p, bytes);
+                    img = img_mapped;
+                    return true;
+                }
+
+                size_t offset() const { return p_ - begin_; }
+                size_t remaining() const { return end_ - p_; }
+
+            private:
+                const char *begin_;
+                const char *p_;
+                const char *end_;
+            };
+
+            template <typename T>
+            void write_pod(std::ostream &out, const T &value)
+            {
+                out.write(reinterpret_cast<const char *>(&value), sizeof(T));
+            }
+
+            void write_point(std::ostream &out, const geometry_msgs::Point &pos)
+            {
+                write_pod(out, pos.x);
+                write_pod(out, pos.y);
+                write_pod(out, pos.z);
+            }
+
+            void write_image(std::ostream &out, const cv::Mat &img)
+            {
+                cv::Mat img_continuous = img.isContinuous() ? img : img.clone();
+                write_pod(out, int32_t(img_continuous.rows));
+                write_pod(out, int32_t(img_continuous.cols));
+                write_pod(out, int32_t(img_continuous.type()));
+                out.write(reinterpret_cast<const char *>(img_continuous.data), img_continuous.total() * img_continuous.elemSize());
+            }
+
+            //flush a file to the disk, or the entries of a directory with O_DIRECTORY, so a rename survives a power loss
+            bool sync_path(const std::string &path, const int flags = O_RDONLY)
+            {
+                const int fd = open(path.c_str(), flags);
+                if (fd < 0)
+                {
+                    return false;
+                }
+                const bool is_synced = fsync(fd) == 0;
+                close(fd);
+                return is_synced;
+            }
+
+            template <typename T>
+            bool read_array(MappedReader &reader, std::vector<T> &array, const size_t n)
+            {
+                //n comes from the file, check it before n * sizeof(T) can overflow
+                const char *p = n <= reader.remaining() / sizeof(T) ? reader.take(n * sizeof(T)) : nullptr;
+                if (p == nullptr)
+                {
+                    return false;
+                }
+                array.resize(n);
+                std::memcpy(array.data(), p, n * sizeof(T));
+                return true;
+            }
+
+            template <typename T>
+            void write_array(std::ostream &out, const std::vector<T> &array)
+            {
+                out.write(reinterpret_cast<const char *>(array.data()), array.size() * sizeof(T));
+            }
+        } // namespace
+
+        ReidSnapshot::ReidSnapshot(const std::string &dir, const int checkpoint_interval)
+            : dir_(dir), checkpoint_interval_(checkpoint_interval)
+        {
+            if (mkdir(dir_.c_str(), 0755) != 0 && errno != EEXIST)
+            {
+                std::cout << "Failed to create the reid snapshot directory " << dir_ << ": " << std::strerror(errno)
+                          << ", the snapshot is disabled." << std::endl;
+                is_valid_ = false;
+            }
+        }
+
+        bool ReidSnapshot::load(ReidDatabase &db)
+        {
+            auto t_start = std::chrono::steady_clock::now();
+            load_checkpoint(db);
+
+            //keep appending to the segment if it belongs to the checkpoint, a torn record at the end is cut off
+            size_t segment_size = replay_segment(db);
+            if (segment_size > 0 && truncate(file_path("segment.bin").c_str(), segment_size) == 0)
+            {
+                segment.open(file_path("segment.bin"), std::ios::binary | std::ios::app);
+            }
+            else
+            {
+                reset_segment();
+            }
+
+            if (db.object_db.empty())
+            {
+                return false;
+            }
+            std::cout << "Load the reid snapshot from " << dir_ << " with " << db.object_db.size() << " objects and "
+                      << db.num_feat << " features in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count()
+                      << " ms." << std::endl;
+            return true;
+        }
+
+        bool ReidSnapshot::load_checkpoint(ReidDatabase &db)
+        {
+            MappedFile file(file_path("checkpoint.bin"));
+            if (!file.valid())
+            {
+                return false;
+            }
+
+            MappedReader reader(file.data(), file.size());
+            CheckpointHeader header;
+            if (!reader.read(header) || std::memcmp(header.magic, checkpoint_magic, sizeof(checkpoint_magic)) != 0 ||
+                header.version != snapshot_version)
+            {
+                std::cout << "Invalid reid snapshot checkpoint in " << dir_ << ", ignore it." << std::endl;
+                return false;
+            }
+            if (header.feat_dimension != db.db_param_.feat_dimension || header.slab_capacity != db.feat_arena.slab_capacity())
+            {
+                std::cout << "The reid snapshot in " << dir_ << " has feature dimension " << header.feat_dimension
+                          << " and max_feat_num_one_object " << header.slab_capacity << ", which do not match the config, ignore it." << std::endl;
+                return false;
+            }
+
+            std::vector<int32_t> feat_num, owner_id, slab_num_in_db_large, slab_released;
+            std::vector<int64_t> label_replaced;
+            std::vector<ObjectType> object_db;
+            //an object takes more than one byte, a torn file can not make this allocate more than its size
+            if (header.object_num >= 0 && size_t(header.object_num) <= reader.remaining())
+            {
+                object_db.reserve(header.object_num);
+            }
+            bool valid = header.label_replaced_num >= 0 && header.slab_released_num >= 0 &&
+                         read_array(reader, feat_num, header.slab_num) &&
+                         read_array(reader, owner_id, header.slab_num) &&
+                         read_array(reader, slab_num_in_db_large, header.slab_num) &&
+                         read_array(reader, label_replaced, header.label_replaced_num) &&
+                         read_array(reader, slab_released, header.slab_released_num);
+            for (int i = 0; valid && i < header.object_num; i++)
+            {
+                int32_t id, slab, object_feat_num;
+                geometry_msgs::Point pos;
+                double last_seen;
+                int32_t is_evicted;
+                cv::Mat example_image;
+                valid = reader.read(id) && reader.read(slab) && reader.read(object_feat_num) &&
+                        reader.read_point(pos) && reader.read(last_seen) && reader.read(is_evicted) && reader.read_image(example_image);
+                if (valid)
+                {
+                    object_db.emplace_back(id, example_image, pos, slab);
+                    object_db.back().feat_num = object_feat_num;
+                    object_db.back().last_seen = last_seen;
+                    object_db.back().is_evicted = is_evicted;
+                }
+            }
+            const size_t feat_size = size_t(header.slab_num) * header.slab_capacity * header.feat_dimension * sizeof(float);
+            if (!valid || header.feat_offset + feat_size > file.size())
+            {
+                std::cout << "Truncated reid snapshot checkpoint in " << dir_ << ", ignore it." << std::endl;
+                return false;
+            }
+
+            //the inverted lists stay memory-mapped by faiss
+            std::unique_ptr<faiss::Index> index;
+            if (header.has_inverted_file)
+            {
+                try
+                {
+                    index.reset(faiss::read_index(file_path(inverted_file_name(header.seq)).c_str(), faiss::IO_FLAG_MMAP));
+                }
+                catch (const std::exception &e)
+                {
+                    std::cout << "Failed to load the inverted file of the reid snapshot: " << e.what() << std::endl;
+                }
+                //the type of the saved index must match large_db_type,
+                //otherwise all the features are searched in the delta database until the inverted file is rebuilt
+                bool is_ivf = dynamic_cast<faiss::IndexIVF *>(index.get()) != nullptr;
+                if (index != nullptr && is_ivf != (db.db_param_.large_db_type != "hnsw"))
+                {
+                    index.reset();
+                }
+            }
+
+            //the features are copied from the mapping in one go, no index is rebuilt
+            //the slabs released since the inverted file was built are kept out of use while it holds their labels
+            db.feat_arena.restore(header.slab_num, reinterpret_cast<const float *>(file.data() + header.feat_offset),
+                                  feat_num.data(), owner_id.data(), index != nullptr ? slab_released : std::vector<int32_t>());
+            db.object_db = std::move(object_db);
+            db.max_id = header.max_id;
+            db.num_feat = 0;
+            for (auto n : feat_num)
+            {
+                db.num_feat += n;
+            }
+            checkpoint_seq = header.seq;
+
+            if (index != nullptr)
+            {
+                set_hnsw_param(*index, db.db_param_);
+                db.db_large = std::move(index);
+                db.num_feat_in_db_large = header.num_feat_in_db_large;
+                db.slab_num_in_db_large = slab_num_in_db_large;
+                //the stale entries stay filtered out of the search results, as before the restart
+                db.num_feat_stale = header.num_feat_stale;
+                db.label_replaced.assign(label_replaced.begin(), label_replaced.end());
+                for (auto label : db.label_replaced)
+                {
+                    db.label_replaced_count[label]++;
+                }
+                db.slab_released = slab_released;
+            }
+            return true;
+        }
+
+        size_t ReidSnapshot::replay_segment(ReidDatabase &db)
+        {
+            MappedFile file(file_path("segment.bin"));
+            if (!file.valid())
+            {
+                return 0;
+            }
+
+            MappedReader reader(file.data(), file.size());
+            SegmentHeader header;
+            if (!reader.read(header) || std::memcmp(header.magic, segment_magic, sizeof(segment_magic)) != 0 ||
+                header.version != snapshot_version || header.checkpoint_seq != checkpoint_seq)
+            {
+                return 0;
+            }
+
+            const int d = db.db_param_.feat_dimension;
+            size_t valid_size = reader.offset();
+            uint32_t type;
+            while (reader.read(type))
+            {
+                bool valid = false;
+                if (type == RECORD_NEW_OBJECT)
+                {
+                    int32_t id, slab;
+                    geometry_msgs::Point pos;
+                    cv::Mat example_image;
+                    valid = reader.read(id) && reader.read(slab) && reader.read_point(pos) && reader.read_image(example_image) &&
+                            id == db.max_id && slab >= 0 && slab <= db.feat_arena.slab_num();
+                    if (valid && slab < db.feat_arena.slab_num() && db.db_large != nullptr)
+                    {
+                        //the slab of an evicted object is reused, the loaded db_large may still hold its labels
+                        db.drop_db_large();
+                    }
+                    if (valid && (valid = db.feat_arena.allocate(id, slab) == slab))
+                    {
+                        db.object_db.emplace_back(id, example_image, pos, slab);
+                        db.max_id++;
+                    }
+                }
+                else if (type == RECORD_FEATURE)
+                {
+                    int32_t slab;
+                    const char *feat = nullptr;
+                    valid = reader.read(slab) && (feat = reader.take(d * sizeof(float))) != nullptr &&
+                            slab >= 0 && slab < db.feat_arena.slab_num();
+                    if (valid)
+                    {
+                        //the segment may not be aligned for float
+                        std::vector<float> feat_aligned(d);
+                        std::memcpy(feat_aligned.data(), feat, d * sizeof(float));
+                        faiss::Index::idx_t label = db.feat_arena.add(slab, feat_aligned.data());
+                        if (label >= 0)
+                        {
+                            db.object_db[db.feat_arena.owner(label)].feat_num++;
+                            db.num_feat++;
+                        }
+                    }
+                }
+                else if (type == RECORD_POSITION)
+                {
+                    int32_t id;
+                    geometry_msgs::Point pos;
+                    double time;
+                    valid = reader.read(id) && reader.read_point(pos) && reader.read(time) && id >= 0 && id < db.object_db.size();
+                    if (valid)
+                    {
+                        db.object_db[id].update_pos(pos, time);
+                    }
+                }
+                else if (type == RECORD_REPLACE_FEATURE)
+                {
+                    int64_t label;
+                    const char *feat = nullptr;
+                    valid = reader.read(label) && (feat = reader.take(d * sizeof(float))) != nullptr &&
+                            label >= 0 && label / db.feat_arena.slab_capacity() < db.feat_arena.slab_num() &&
+                            label % db.feat_arena.slab_capacity() < db.feat_arena.size(label / db.feat_arena.slab_capacity());
+                    if (valid)
+                    {
+                        std::vector<float> feat_aligned(d);
+                        std::memcpy(feat_aligned.data(), feat, d * sizeof(float));
+                        db.replace_feature(label, feat_aligned.data());
+                    }
+                }
+                else if (type == RECORD_EVICT_OBJECT)
+                {
+                    int32_t id;
+                    valid = reader.read(id) && id >= 0 && id < db.object_db.size() && !db.object_db[id].is_evicted;
+                    if (valid)
+                    {
+                        db.evict_object(id);
+                    }
+                }
+
+                if (!valid)
+                {
+                    std::cout << "Found a broken record in the reid snapshot segment, drop the rest of it." << std::endl;
+                    break;
+                }
+                valid_size = reader.offset();
+                segment_record_num++;
+            }
+            return valid_size;
+        }
+
+        void ReidSnapshot::checkpoint(const ReidDatabase &db)
+        {
+            auto t_start = std::chrono::steady_clock::now();
+            const FeatureArena &arena = db.feat_arena;
+            const uint32_t seq = checkpoint_seq + 1;
+
+            CheckpointHeader header{};
+            std::memcpy(header.magic, checkpoint_magic, sizeof(checkpoint_magic));
+            header.version = snapshot_version;
+            header.seq = seq;
+            header.feat_dimension = db.db_param_.feat_dimension;
+            header.slab_capacity = arena.slab_capacity();
+            header.slab_num = arena.slab_num();
+            header.object_num = db.object_db.size();
+            header.max_id = db.max_id;
+            //db_large is saved with its stale entries, they are filtered the same way after loading
+            //(a db_large being built in the background is not saved, it is built again later)
+            const bool save_db_large = db.db_large != nullptr;
+            header.has_inverted_file = save_db_large;
+            header.num_feat_in_db_large = save_db_large ? db.num_feat_in_db_large : 0;
+            header.num_feat_stale = save_db_large ? db.num_feat_stale : 0;
+            header.label_replaced_num = save_db_large ? db.label_replaced.size() : 0;
+            header.slab_released_num = save_db_large ? db.slab_released.size() : 0;
+            header.feat_offset = 0;
+
+            //the index is written under a temporary name, and only takes its name once the checkpoint is complete
+            const std::string index_tmp = file_path(inverted_file_name(seq) + ".tmp");
+            if (save_db_large)
+            {
+                try
+                {
+                    faiss::write_index(db.db_large.get(), index_tmp.c_str());
+                }
+                catch (const std::exception &e)
+                {
+                    std::cout << "Failed to write the inverted file of the reid snapshot: " << e.what() << std::endl;
+                    std::remove(index_tmp.c_str());
+                    return;
+                }
+            }
+
+            std::vector<int32_t> feat_num(arena.slab_num()), owner_id(arena.slab_num()), slab_num_in_db_large(arena.slab_num(), 0);
+            for (int s = 0; s < arena.slab_num(); s++)
+            {
+                feat_num[s] = arena.size(s);
+                owner_id[s] = arena.owner(arena.label(s, 0));
+                if (save_db_large && s < db.slab_num_in_db_large.size())
+                {
+                    slab_num_in_db_large[s] = db.slab_num_in_db_large[s];
+                }
+            }
+
+            std::ofstream out(file_path("checkpoint.bin.tmp"), std::ios::binary | std::ios::trunc);
+            write_pod(out, header);
+            write_array(out, feat_num);
+            write_array(out, owner_id);
+            write_array(out, slab_num_in_db_large);
+            if (save_db_large)
+            {
+                write_array(out, std::vector<int64_t>(db.label_replaced.begin(), db.label_replaced.end()));
+                write_array(out, std::vector<int32_t>(db.slab_released.begin(), db.slab_released.end()));
+            }
+            for (const auto &ob : db.object_db)
+            {
+                write_pod(out, int32_t(ob.id));
+                write_pod(out, int32_t(ob.slab));
+                write_pod(out, int32_t(ob.feat_num));
+                write_point(out, ob.pos);
+                write_pod(out, ob.last_seen);
+                write_pod(out, int32_t(ob.is_evicted));
+                write_image(out, ob.example_image);
+            }
+
+            //the feature arena starts at an aligned offset, so it can be read as floats right from the mapping
+            const size_t offset = out.tellp();
+            header.feat_offset = (offset + feat_alignment - 1) / feat_alignment * feat_alignment;
+            out.write(std::string(header.feat_offset - offset, '\0').data(), header.feat_offset - offset);
+            out.write(reinterpret_cast<const char *>(arena.data()),
+                      size_t(arena.slab_num()) * arena.slab_capacity() * header.feat_dimension * sizeof(float));
+            out.seekp(0);
+            write_pod(out, header);
+            out.close();
+            //the data of both files has to be on the disk before they take their names, since the segment is truncated after that
+            if (!out || !sync_path(file_path("checkpoint.bin.tmp")) || (save_db_large && !sync_path(index_tmp)) ||
+                (save_db_large && std::rename(index_tmp.c_str(), file_path(inverted_file_name(seq)).c_str()) != 0))
+            {
+                std::cout << "Failed to write the reid snapshot checkpoint to " << dir_ << std::endl;
+                std::remove(index_tmp.c_str());
+                std::remove(file_path("checkpoint.bin.tmp").c_str());
+                return;
+            }
+
+            //the new checkpoint replaces the old one and its segment atomically
+            if (std::rename(file_path("checkpoint.bin.tmp").c_str(), file_path("checkpoint.bin").c_str()) != 0)
+            {
+                std::cout << "Failed to replace the reid snapshot checkpoint in " << dir_ << std::endl;
+                std::remove(file_path(inverted_file_name(seq)).c_str());
+                std::remove(file_path("checkpoint.bin.tmp").c_str());
+                return;
+            }
+            //the renames have to be on the disk before the old segment and index go
+            //if not, both are kept and the segment (still of the old checkpoint) is ignored if the new checkpoint is loaded
+            if (!sync_path(dir_, O_RDONLY | O_DIRECTORY))
+            {
+                std::cout << "Failed to sync the reid snapshot directory " << dir_ << ": " << std::strerror(errno) << std::endl;
+                return;
+            }
+            std::remove(file_path(inverted_file_name(checkpoint_seq)).c_str());
+            checkpoint_seq = seq;
+            reset_segment();
+            std::cout << "Write the reid snapshot checkpoint with " << db.object_db.size() << " objects in "
+                      << std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count()
+                      << " ms." << std::endl;
+        }
+
+        void ReidSnapshot::log_new_object(const int id, const int slab, const geometry_msgs::Point &pos, const cv::Mat &example_image)
+        {
+            write_pod(segment, RECORD_NEW_OBJECT);
+            write_pod(segment, int32_t(id));
+            write_pod(segment, int32_t(slab));
+            write_point(segment, pos);
+            write_image(segment, example_image);
+            segment_record_num++;
+        }
+
+        void ReidSnapshot::log_feature(const int slab, const float *feat, const int feat_dimension)
+        {
+            write_pod(segment, RECORD_FEATURE);
+            write_pod(segment, int32_t(slab));
+            segment.write(reinterpret_cast<const char *>(feat), feat_dimension * sizeof(float));
+            segment_record_num++;
+        }
+
+        void ReidSnapshot::log_position(const int id, const geometry_msgs::Point &pos, const double time)
+        {
+            write_pod(segment, RECORD_POSITION);
+            write_pod(segment, int32_t(id));
+            write_point(segment, pos);
+            write_pod(segment, time);
+            segment_record_num++;
+        }
+
+        void ReidSnapshot::log_replace_feature(const faiss::Index::idx_t label, const float *feat, const int feat_dimension)
+        {
+            write_pod(segment, RECORD_REPLACE_FEATURE);
+            write_pod(segment, int64_t(label));
+            segment.write(reinterpret_cast<const char *>(feat), feat_dimension * sizeof(float));
+            segment_record_num++;
+        }
+
+        void ReidSnapshot::log_evict_object(const int id)
+        {
+            write_pod(segment, RECORD_EVICT_OBJECT);
+            write_pod(segment, int32_t(id));
+            segment_record_num++;
+        }
+
+        void ReidSnapshot::reset_segment()
+        {
+            if (segment.is_open())
+            {
+                segment.close();
+            }
+            segment.open(file_path("segment.bin"), std::ios::binary | std::ios::trunc);
+            SegmentHeader header{};
+            std::memcpy(header.magic, segment_magic, sizeof(segment_magic));
+            header.version = snapshot_version;
+            header.checkpoint_seq = checkpoint_seq;
+            write_pod(segment, header);
+            segment.flush();
+            segment_record_num = 0;
+        }
+    } // namespace reid
+} // namespace ptl
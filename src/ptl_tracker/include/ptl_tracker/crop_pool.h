@@ -0,0 +1,65 @@
+#pragma once
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ptl
+{
+    namespace tracker
+    {
+        struct CropPoolParam
+        {
+            int slot_num = 512;       // number of crops the pool holds, the slab is allocated once at init
+            int track_capacity = 32;  // crops kept for a tracking object at most, the oldest one is overwritten when it is full
+            int width = 128;          // size of a crop slot, same as the input of the reid model
+            int height = 256;
+        };
+
+        struct CropPoolStats
+        {
+            int slot_num = 0;
+            int used_slot_num = 0;
+            int track_num = 0;
+            size_t bytes_reserved = 0; // size of the slab
+            size_t bytes_used = 0;     // size of the used slots
+            long int drop_num = 0;     // crops dropped because the pool was full
+        };
+
+        // pool of fixed-size BGR crop slots for the image blocks of the tracking objects
+        // a crop is resized into a slot of one preallocated slab, so a stored image block does not keep the whole camera frame alive,
+        // each tracking object owns a ring of at most track_capacity slots, which go back to the pool when the object dies
+        class CropPool
+        {
+        public:
+            void init(const CropPoolParam &param);
+
+            //resize the crop into a slot of the track, the slot is returned in block (it shares the storage of the pool)
+            //return the index of the slot in the ring of the track, which is the size of the ring if the slot is appended,
+            //or -1 if the crop is dropped because there is no free slot
+            int put(const int track_id, const cv::Mat &crop, cv::Mat &block);
+
+            //give the slots of a track back to the pool, the blocks of the track must not be used after that
+            void release(const int track_id);
+
+            CropPoolStats stats() const;
+
+        private:
+            struct TrackRing
+            {
+                std::vector<int> slots;
+                int next = 0; // index of the slot to overwrite when the ring is full
+            };
+
+            cv::Mat slot(const int slot_id) const { return slab_.rowRange(slot_id * param_.height, (slot_id + 1) * param_.height); }
+
+            CropPoolParam param_;
+            cv::Mat slab_; // slot_num * height x width, CV_8UC3
+            std::vector<int> free_slots_;
+            std::unordered_map<int, TrackRing> tracks_;
+            long int drop_num_ = 0;
+            mutable std::mutex mtx_; // the tracker thread fills the pool, the stats may be read from any thread
+        };
+    } // namespace tracker
+} // namespace ptl
@@ -0,0 +1,37 @@
+#pragma once
+#include <vector>
+
+#include <opencv2/core.hpp>
+
+namespace ptl
+{
+    namespace tracker
+    {
+        // fixed-capacity history of the reid features of a tracking object, stored in half precision
+        // when it is full, a new feature replaces the stored feature that is closest to the others, if the new one is more distinct
+        // an exact copy of a stored feature (e.g. reused by the embedding cache of the real-time reid) is always dropped
+        // the features are the rows of a CV_16F matrix, which can be handed over to the offline reid without copying
+        class FeatureReservoir
+        {
+        public:
+            FeatureReservoir() = default;
+            FeatureReservoir(const int capacity) : capacity_(capacity) {}
+
+            //add a feature of feat_dimension floats, return false if it is dropped
+            bool add(const float *feat, const int feat_dimension);
+
+            //the stored features, size() x feat_dimension CV_16F, it shares the storage of the reservoir
+            cv::Mat features() const { return feat_.rowRange(0, size_); }
+
+            int size() const { return size_; }
+            int capacity() const { return capacity_; }
+
+        private:
+            int capacity_ = 32;
+            int size_ = 0;
+            cv::Mat feat_;                    // capacity x feat_dimension, CV_16F
+            cv::Mat distance_;                // capacity x capacity, squared L2 distances between the stored features
+            std::vector<float> nn_distance_;  // squared L2 distance of each stored feature to its nearest stored feature
+        };
+    } // namespace tracker
+} // namespace ptl
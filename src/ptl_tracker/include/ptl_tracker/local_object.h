@@ -6,6 +6,7 @@
 #include <ros/ros.h>
 #include <Eigen/Dense>
 
+#include "ptl_tracker/feature_reservoir.h"
 #include "ptl_tracker/kalman_filter.h"
 #include "ptl_tracker/kalman_filter_3d.h"
 #include "ptl_tracker/timer.hpp"
@@ -51,10 +52,11 @@ namespace ptl
             cv::Scalar color;
             bool is_track_succeed;
             std::vector<cv::Mat> img_blocks;
+            std::vector<bool> img_blocks_occluded; // whether this object overlapped with another one when each image block was taken
+            std::vector<cv::Size> img_blocks_size; // size of each image block in the frame, before it is resized into the crop pool
 
-            std::vector<Eigen::VectorXf> features;
             Eigen::VectorXf features_now;
-            std::vector<float> features_vector;
+            FeatureReservoir feature_reservoir; // history of the reid features, handed over to the offline reid
             geometry_msgs::Point position;
 
             cv::Mat example_image;
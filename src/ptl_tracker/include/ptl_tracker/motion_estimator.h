@@ -0,0 +1,35 @@
+#pragma once
+#include <opencv2/core.hpp>
+
+namespace ptl
+{
+    namespace tracker
+    {
+        struct MotionEstimatorParam
+        {
+            int block_size = 16;              // side of a block in the gray frame of the optical flow (in resized pixels)
+            double block_diff_threshold = 8;  // a block moves if the mean absolute difference of its pixels is above this gray level
+        };
+
+        // cheap estimation of the change between two frames, on the downscaled gray frame the optical flow already computes
+        // the absolute difference of the frames is averaged over blocks, and the ratio of the blocks above the threshold is the motion ratio
+        class MotionEstimator
+        {
+        public:
+            MotionEstimator() = default;
+            MotionEstimator(const MotionEstimatorParam &param) : param_(param) {}
+
+            //compare the gray frame with the previous one, and return the ratio of the moving blocks in [0, 1]
+            //the first frame (or a frame of a new size) counts as a full change
+            double update(const cv::Mat &gray);
+
+            double motion_ratio() const { return motion_ratio_; }
+
+        private:
+            MotionEstimatorParam param_;
+            cv::Mat gray_pre_;
+            cv::Mat diff_, block_diff_; // reused between frames
+            double motion_ratio_ = 1.0;
+        };
+    } // namespace tracker
+} // namespace ptl
@@ -40,6 +40,9 @@ namespace ptl
             OpticalFlow(const OpticalFlowParam &optical_flow_param) : optical_flow_param_(optical_flow_param) {}
             void update(const cv::Mat &frame_curr, std::vector<LocalObject> &local_objects);
 
+            //the (resized) gray frame of the last update
+            const cv::Mat &gray_frame() const { return frame_pre_; }
+
         private:
             void detect_enough_keypoints(std::vector<LocalObject> &local_objects, std::vector<cv::Point2f> &keypoints_all);
             void camera_motion_compensate(std::vector<cv::Point2f> &keypoints_all, const std::vector<uchar> &status);
@@ -0,0 +1,79 @@
+#pragma once
+#include <atomic>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+namespace ptl
+{
+    namespace tracker
+    {
+        // bounded lock-free ring buffer with a single producer thread and a single consumer thread
+        // the producer only writes the tail and the consumer only writes the head, so neither of them ever waits for the other
+        template <typename T>
+        class SpscQueue
+        {
+        public:
+            //not thread safe, call it before both threads start
+            void init(const size_t capacity)
+            {
+                slots_ = std::vector<T>(capacity + 1); // one slot is kept empty to tell a full ring from an empty one
+                head_.store(0, std::memory_order_relaxed);
+                tail_.store(0, std::memory_order_relaxed);
+            }
+
+            //producer: whether a push would fail, only the consumer can change it (to false)
+            bool full() const
+            {
+                const size_t tail = tail_.load(std::memory_order_relaxed);
+                return (tail + 1) % slots_.size() == head_.load(std::memory_order_acquire);
+            }
+
+            //producer: return false if the ring is full
+            bool push(T &&item)
+            {
+                const size_t tail = tail_.load(std::memory_order_relaxed);
+                const size_t next = (tail + 1) % slots_.size();
+                if (next == head_.load(std::memory_order_acquire))
+                {
+                    return false;
+                }
+                slots_[tail] = std::move(item);
+                tail_.store(next, std::memory_order_release);
+                return true;
+            }
+
+            //consumer: the oldest item, or nullptr if the ring is empty
+            T *front()
+            {
+                const size_t head = head_.load(std::memory_order_relaxed);
+                if (head == tail_.load(std::memory_order_acquire))
+                {
+                    return nullptr;
+                }
+                return &slots_[head];
+            }
+
+            //consumer: drop the oldest item, only after front() returned it
+            void pop()
+            {
+                const size_t head = head_.load(std::memory_order_relaxed);
+                slots_[head] = T(); // release what the item holds (images, point clouds) now
+                head_.store((head + 1) % slots_.size(), std::memory_order_release);
+            }
+
+            //either thread, only a hint since the other thread may change it
+            size_t size() const
+            {
+                const size_t head = head_.load(std::memory_order_acquire);
+                const size_t tail = tail_.load(std::memory_order_acquire);
+                return (tail + slots_.size() - head) % slots_.size();
+            }
+
+        private:
+            std::vector<T> slots_ = std::vector<T>(1);
+            std::atomic<size_t> head_{0}; // next item to pop, written by the consumer
+            std::atomic<size_t> tail_{0}; // next slot to push, written by the producer
+        };
+    } // namespace tracker
+} // namespace ptl
@@ -1,7 +1,13 @@
 #pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
 #include <iostream>
+#include <memory>
 #include <mutex>
 #include <string>
+#include <thread>
 
 //ros
 #include "ros/ros.h"
@@ -24,6 +30,11 @@
 #include <sensor_msgs/PointCloud2.h>
 #include <visualization_msgs/Marker.h>
 
+#include "ptl_tracker/crop_pool.h"
+#include "ptl_tracker/motion_estimator.h"
+#include "ptl_tracker/tracker_health.h"
+#include "ptl_tracker/tracker_snapshot.h"
+#include "ptl_tracker/spsc_queue.hpp"
 #include "ptl_tracker/optical_flow.h"
 #include "ptl_tracker/association_type.hpp"
 #include "ptl_tracker/point_cloud_processor.h"
@@ -34,25 +45,91 @@ namespace ptl
 {
     namespace tracker
     {
+        // all the tracking objects belong to a single tracker thread
+        // the frames, the detection results and the lidar scans are posted as commands to lock-free queues (one for each source,
+        // with a single producer thread each), and the tracker thread applies them in the order they were posted
+        // (a command is numbered only once it surely fits in its queue, and a later number waits for an earlier one still being pushed);
+        // the other threads read the immutable snapshot published after each command, so no lock is taken on the tracking objects
         class TrackerInterface
         {
         public:
             TrackerInterface() = default;
             TrackerInterface(const ros::NodeHandle &n) : nh_(n) {}
+            ~TrackerInterface();
 
+            //load config and start the tracker thread
             void init();
 
+            //post a camera frame, the tracker updates the bboxes by optical flow and removes the dead tracking objects
+            //return false if the frame is dropped because the queue is full
+            bool push_frame(const cv::Mat &img, const ros::Time &update_time);
+
+            //post the detected bboxes and their reid features (flattened) of an image
+            bool push_detection(const cv::Mat &img,
+                                const std::vector<cv::Rect2d> &bboxes,
+                                const std::vector<float> &feature,
+                                const ros::Time &update_time);
+
+            //post a lidar scan to locate the tracking objects
+            bool push_lidar(const sensor_msgs::PointCloud2ConstPtr &msg_pc);
+
+            //called on the tracker thread with the tracking objects removed by a frame, set it before init()
+            void set_dead_object_callback(const std::function<void(const std::vector<LocalObject> &)> &callback) { dead_object_callback = callback; }
+
+            //the last published state, it may be a command behind the posted ones
+            std::shared_ptr<const TrackerSnapshot> snapshot() const { return std::atomic_load(&snapshot_); }
+
+            //copy the ids and bboxes of the tracking objects
+            void get_tracking_bboxes(std::vector<int> &ids, std::vector<cv::Rect2d> &bboxes) const;
+
+            //occupancy and memory of the pool of the image blocks
+            CropPoolStats crop_pool_stats() const { return snapshot()->crop_pool_stats; }
+
+            //ratio of the moving blocks between the last two frames
+            double motion_ratio() const { return snapshot()->motion_ratio; }
+
+            //summary of the tick counts, overlap and keypoints of the tracking objects
+            TrackerHealth health() const { return snapshot()->health; }
+
+        private:
+            struct FrameCommand
+            {
+                uint64_t seq = 0; // order of posting among all the commands
+                cv::Mat img;
+                ros::Time update_time;
+            };
+
+            struct DetectionCommand
+            {
+                uint64_t seq = 0;
+                cv::Mat img;
+                std::vector<cv::Rect2d> bboxes;
+                std::vector<float> feature;
+                ros::Time update_time;
+            };
+
+            struct LidarCommand
+            {
+                uint64_t seq = 0;
+                sensor_msgs::PointCloud2ConstPtr msg_pc;
+            };
+
+            void load_config(ros::NodeHandle *n);
+
+            //the tracker thread: apply the pending commands in order, and sleep when there is none
+            void command_loop();
+            bool apply_next_command();
+            bool has_next_command(); // whether the command of next_command_seq is in a queue
+            void wake_up();
+            void publish_snapshot();
+
             //udpate bbox by optical tracker and return the dead tracker
             std::vector<LocalObject> update_bbox_by_tracker(const cv::Mat &img, const ros::Time &update_time);
             void update_bbox_by_detector(const cv::Mat &img,
                                          const std::vector<cv::Rect2d> &bboxes,
-                                         const std::vector<float> feature,
+                                         const std::vector<float> &feature,
                                          const ros::Time &update_time);
-
-            void lidar_tracker_callback(const sensor_msgs::PointCloud2ConstPtr &msg_pc);
-
-        private:
-            void load_config(ros::NodeHandle *n);
+            void update_position_by_lidar(const sensor_msgs::PointCloud2ConstPtr &msg_pc);
 
             bool update_local_database(LocalObject &local_object, const cv::Mat &img_block);
 
@@ -85,10 +162,8 @@ namespace ptl
             std::vector<cv::Rect2d> bbox_ros_to_opencv(const std::vector<std_msgs::UInt16MultiArray> &bbox_ros);
             void bbox_rect(const cv::Rect2d &bbox_max);
 
-        public:
-            std::vector<LocalObject> local_objects_list;
+            std::vector<LocalObject> local_objects_list; // owned by the tracker thread
 
-        private:
             ros::NodeHandle nh_;
             ros::Publisher m_track_vis_pub, m_track_marker_pub;
             ros::Publisher m_pc_filtered_debug, m_pc_cluster_debug;
@@ -99,11 +174,26 @@ namespace ptl
             tf2_ros::TransformListener *tf_listener = new tf2_ros::TransformListener(tf_buffer);
             geometry_msgs::TransformStamped lidar2camera, lidar2map, camera2map;
 
-            //lock
-            std::mutex mtx;
+            //commands and the tracker thread
+            SpscQueue<FrameCommand> frame_queue;
+            SpscQueue<DetectionCommand> detection_queue;
+            SpscQueue<LidarCommand> lidar_queue;
+            std::atomic<uint64_t> command_seq{0}; // next sequence number to give to a command
+            uint64_t next_command_seq = 0;        // next sequence number to apply, on the tracker thread
+            std::atomic<long int> command_drop_num{0};
+            TrackerCommandStats command_stats; // written by the tracker thread only
+            ros::Time last_update_time;        // of the last applied frame or detection
+            std::mutex wake_mtx;               // only to park the idle tracker thread, the queues take no lock
+            std::condition_variable wake_cv;
+            std::atomic<bool> is_shutdown{false};
+            std::thread tracker_thread;
+            std::shared_ptr<const TrackerSnapshot> snapshot_ = std::make_shared<TrackerSnapshot>();
+            std::function<void(const std::vector<LocalObject> &)> dead_object_callback;
             ReidInfo reid_infos;
 
             OpticalFlow opt_tracker;
+            CropPool crop_pool; // storage of the image blocks of the local objects
+            MotionEstimator motion_estimator;
             int local_id_not_assigned = 0;
 
             //params
@@ -127,10 +217,14 @@ namespace ptl
             double reid_match_bbox_size_diff = 30;
             int match_centroid_padding = 20;
             float feature_smooth_ratio = 0.8;
+            int feature_reservoir_capacity = 32;
 
             //params
             PointCloudProcessorParam pcp_param;
+            CropPoolParam crop_pool_param;
             OpticalFlowParam opt_param;
+            MotionEstimatorParam motion_param;
+            int command_queue_size = 8;
             KalmanFilterParam kf_param;
             KalmanFilter3dParam kf3d_param;
             CameraIntrinsic camera_intrinsic;
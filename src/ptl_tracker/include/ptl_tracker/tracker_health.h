@@ -0,0 +1,18 @@
+#pragma once
+#include <limits>
+
+namespace ptl
+{
+    namespace tracker
+    {
+        // summary of the health of the tracking objects, to schedule the detections
+        struct TrackerHealth
+        {
+            int track_num = 0;
+            int min_ticks_to_timeout = std::numeric_limits<int>::max(); // the least ticks before an object times out (tracking fail or no detector update)
+            int failing_num = 0;                                        // objects whose last optical flow tracking failed
+            int overlap_num = 0;                                        // objects overlapping with another one
+            int min_keypoint_num = std::numeric_limits<int>::max();     // the least keypoints tracked by the optical flow in an object
+        };
+    } // namespace tracker
+} // namespace ptl
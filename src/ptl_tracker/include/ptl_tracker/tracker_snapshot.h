@@ -0,0 +1,36 @@
+#pragma once
+#include <vector>
+
+#include <opencv2/core.hpp>
+#include "ros/ros.h"
+
+#include "ptl_tracker/crop_pool.h"
+#include "ptl_tracker/tracker_health.h"
+
+namespace ptl
+{
+    namespace tracker
+    {
+        struct TrackerCommandStats
+        {
+            long int frame_num = 0;     // commands applied by the tracker thread
+            long int detection_num = 0;
+            long int lidar_num = 0;
+            long int drop_num = 0;      // commands dropped because their queue was full
+            size_t pending_num = 0;     // commands waiting when the snapshot is taken
+        };
+
+        // immutable copy of the tracker state, published by the tracker thread after each command
+        // the other threads read it instead of the tracking objects, which only the tracker thread touches
+        struct TrackerSnapshot
+        {
+            ros::Time stamp;               // time of the last applied frame or detection
+            std::vector<int> ids;          // ids and bboxes of the tracking objects
+            std::vector<cv::Rect2d> bboxes;
+            TrackerHealth health;
+            double motion_ratio = 0;       // ratio of the moving blocks between the last two frames
+            CropPoolStats crop_pool_stats;
+            TrackerCommandStats command_stats;
+        };
+    } // namespace tracker
+} // namespace ptl
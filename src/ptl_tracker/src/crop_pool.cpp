@@ -0,0 +1,78 @@
+#include <opencv2/imgproc.hpp>
+
+#include "ptl_tracker/crop_pool.h"
+
+namespace ptl
+{
+    namespace tracker
+    {
+        void CropPool::init(const CropPoolParam &param)
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            param_ = param;
+            slab_.create(param_.slot_num * param_.height, param_.width, CV_8UC3);
+            tracks_.clear();
+            free_slots_.clear();
+            //hand out the low slots first
+            for (int i = param_.slot_num - 1; i >= 0; i--)
+            {
+                free_slots_.push_back(i);
+            }
+        }
+
+        int CropPool::put(const int track_id, const cv::Mat &crop, cv::Mat &block)
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            TrackRing &ring = tracks_[track_id];
+            int index;
+            if (ring.slots.size() < param_.track_capacity && !free_slots_.empty())
+            {
+                index = ring.slots.size();
+                ring.slots.push_back(free_slots_.back());
+                free_slots_.pop_back();
+            }
+            else if (!ring.slots.empty())
+            {
+                //overwrite the oldest crop of this track
+                index = ring.next;
+                ring.next = (ring.next + 1) % ring.slots.size();
+            }
+            else
+            {
+                tracks_.erase(track_id);
+                drop_num_++;
+                return -1;
+            }
+
+            block = slot(ring.slots[index]);
+            cv::resize(crop, block, block.size(), 0, 0, cv::INTER_LINEAR);
+            return index;
+        }
+
+        void CropPool::release(const int track_id)
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            auto it = tracks_.find(track_id);
+            if (it == tracks_.end())
+            {
+                return;
+            }
+            free_slots_.insert(free_slots_.end(), it->second.slots.begin(), it->second.slots.end());
+            tracks_.erase(it);
+        }
+
+        CropPoolStats CropPool::stats() const
+        {
+            std::lock_guard<std::mutex> lk(mtx_);
+            CropPoolStats s;
+            const size_t slot_bytes = size_t(param_.width) * param_.height * 3;
+            s.slot_num = param_.slot_num;
+            s.used_slot_num = param_.slot_num - free_slots_.size();
+            s.track_num = tracks_.size();
+            s.bytes_reserved = slot_bytes * s.slot_num;
+            s.bytes_used = slot_bytes * s.used_slot_num;
+            s.drop_num = drop_num_;
+            return s;
+        }
+    } // namespace tracker
+} // namespace ptl
@@ -0,0 +1,77 @@
+#include <algorithm>
+#include <limits>
+
+#include "ptl_tracker/feature_reservoir.h"
+
+namespace ptl
+{
+    namespace tracker
+    {
+        bool FeatureReservoir::add(const float *feat, const int feat_dimension)
+        {
+            if (capacity_ <= 0)
+            {
+                return false;
+            }
+            if (feat_.empty())
+            {
+                feat_.create(capacity_, feat_dimension, CV_16F);
+                distance_ = cv::Mat::zeros(capacity_, capacity_, CV_32F);
+                nn_distance_.assign(capacity_, std::numeric_limits<float>::max());
+            }
+
+            //distances between the new feature, rounded as it would be stored, and the stored ones
+            cv::Mat query_half, query;
+            cv::Mat(1, feat_dimension, CV_32F, const_cast<float *>(feat)).convertTo(query_half, CV_16F);
+            query_half.convertTo(query, CV_32F);
+            cv::Mat stored;
+            feat_.rowRange(0, size_).convertTo(stored, CV_32F);
+            std::vector<float> distance(size_);
+            for (int i = 0; i < size_; i++)
+            {
+                distance[i] = cv::norm(stored.row(i), query, cv::NORM_L2SQR);
+            }
+            //a copy of a stored feature adds nothing
+            if (size_ > 0 && *std::min_element(distance.begin(), distance.end()) == 0)
+            {
+                return false;
+            }
+
+            //when full, replace the most redundant feature if the new one adds more variety
+            int slot = size_;
+            if (size_ < capacity_)
+            {
+                size_++;
+            }
+            else
+            {
+                slot = std::min_element(nn_distance_.begin(), nn_distance_.end()) - nn_distance_.begin();
+                if (*std::min_element(distance.begin(), distance.end()) <= nn_distance_[slot])
+                {
+                    return false;
+                }
+            }
+            cv::Mat row = feat_.row(slot);
+            query_half.copyTo(row);
+
+            for (int j = 0; j < size_; j++)
+            {
+                float d = j == slot ? 0 : distance[j];
+                distance_.at<float>(slot, j) = d;
+                distance_.at<float>(j, slot) = d;
+            }
+            for (int i = 0; i < size_; i++)
+            {
+                nn_distance_[i] = std::numeric_limits<float>::max();
+                for (int j = 0; j < size_; j++)
+                {
+                    if (j != i)
+                    {
+                        nn_distance_[i] = std::min(nn_distance_[i], distance_.at<float>(i, j));
+                    }
+                }
+            }
+            return true;
+        }
+    } // namespace tracker
+} // namespace ptl
@@ -11,7 +11,7 @@ namespace ptl
         LocalObject::LocalObject(const int id_init, const cv::Rect2d &bbox_init, const Eigen::VectorXf &feat,
                                  const KalmanFilterParam &kf_param_init, const KalmanFilter3dParam &kf3d_param_init,
                                  const ros::Time &time_now, const cv::Mat &image)
-            : id(id_init), bbox(bbox_init), features({feat}), features_now(feat), bbox_last_update_time(time_now), example_image(image)
+            : id(id_init), bbox(bbox_init), features_now(feat), bbox_last_update_time(time_now), example_image(image)
         {
             //init kalman filters
             kf = new KalmanFilter(kf_param_init);
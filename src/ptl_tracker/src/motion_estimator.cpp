@@ -0,0 +1,36 @@
+#include <algorithm>
+
+#include <opencv2/imgproc.hpp>
+
+#include "ptl_tracker/motion_estimator.h"
+
+namespace ptl
+{
+    namespace tracker
+    {
+        double MotionEstimator::update(const cv::Mat &gray)
+        {
+            if (gray.empty())
+            {
+                return motion_ratio_;
+            }
+            if (gray_pre_.empty() || gray_pre_.size() != gray.size())
+            {
+                gray_pre_ = gray;
+                motion_ratio_ = 1.0;
+                return motion_ratio_;
+            }
+
+            //the area interpolation gives the mean of each block
+            cv::absdiff(gray, gray_pre_, diff_);
+            const cv::Size block_num(std::max(1, gray.cols / param_.block_size), std::max(1, gray.rows / param_.block_size));
+            cv::resize(diff_, block_diff_, block_num, 0, 0, cv::INTER_AREA);
+            cv::threshold(block_diff_, block_diff_, param_.block_diff_threshold, 255, cv::THRESH_BINARY);
+            motion_ratio_ = 1.0 * cv::countNonZero(block_diff_) / block_diff_.total();
+
+            //the optical flow makes a new gray frame for each update, so it can be kept without a copy
+            gray_pre_ = gray;
+            return motion_ratio_;
+        }
+    } // namespace tracker
+} // namespace ptl
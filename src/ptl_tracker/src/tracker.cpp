@@ -17,11 +17,189 @@ namespace ptl
         {
             load_config(&nh_);
             opt_tracker = OpticalFlow(opt_param);
+            motion_estimator = MotionEstimator(motion_param);
+            crop_pool.init(crop_pool_param);
 
             //publisher
             m_track_vis_pub = nh_.advertise<sensor_msgs::Image>("tracker_results", 1);
             m_track_marker_pub = nh_.advertise<visualization_msgs::Marker>("marker_tracking", 1);
             m_pc_filtered_debug = nh_.advertise<sensor_msgs::PointCloud2>("point_cloud_tracking", 1);
+
+            //commands
+            frame_queue.init(command_queue_size);
+            detection_queue.init(command_queue_size);
+            lidar_queue.init(command_queue_size);
+            publish_snapshot();
+            tracker_thread = std::thread(&TrackerInterface::command_loop, this);
+        }
+
+        TrackerInterface::~TrackerInterface()
+        {
+            is_shutdown = true;
+            wake_up();
+            if (tracker_thread.joinable())
+            {
+                tracker_thread.join();
+            }
+        }
+
+        bool TrackerInterface::push_frame(const cv::Mat &img, const ros::Time &update_time)
+        {
+            if (frame_queue.full())
+            {
+                command_drop_num++;
+                ROS_WARN("The tracker is busy, drop a frame!");
+                return false;
+            }
+            FrameCommand command;
+            command.img = img;
+            command.update_time = update_time;
+            //a command takes its sequence number only when it surely goes into the queue, so the numbers have no gap
+            command.seq = command_seq++;
+            frame_queue.push(std::move(command));
+            wake_up();
+            return true;
+        }
+
+        bool TrackerInterface::push_detection(const cv::Mat &img,
+                                              const std::vector<cv::Rect2d> &bboxes,
+                                              const std::vector<float> &feature,
+                                              const ros::Time &update_time)
+        {
+            if (detection_queue.full())
+            {
+                command_drop_num++;
+                ROS_WARN("The tracker is busy, drop a detection result!");
+                return false;
+            }
+            DetectionCommand command;
+            command.img = img;
+            command.bboxes = bboxes;
+            command.feature = feature;
+            command.update_time = update_time;
+            command.seq = command_seq++;
+            detection_queue.push(std::move(command));
+            wake_up();
+            return true;
+        }
+
+        bool TrackerInterface::push_lidar(const sensor_msgs::PointCloud2ConstPtr &msg_pc)
+        {
+            if (lidar_queue.full())
+            {
+                command_drop_num++;
+                ROS_WARN("The tracker is busy, drop a lidar scan!");
+                return false;
+            }
+            LidarCommand command;
+            command.msg_pc = msg_pc;
+            command.seq = command_seq++;
+            lidar_queue.push(std::move(command));
+            wake_up();
+            return true;
+        }
+
+        void TrackerInterface::wake_up()
+        {
+            //taking the lock makes sure the tracker thread is either before its check of the queues or already waiting
+            {
+                lock_guard<mutex> lk(wake_mtx);
+            }
+            wake_cv.notify_one();
+        }
+
+        void TrackerInterface::command_loop()
+        {
+            while (!is_shutdown && ros::ok())
+            {
+                if (apply_next_command())
+                {
+                    publish_snapshot();
+                    continue;
+                }
+                //wake up now and then to check the shutdown
+                std::unique_lock<mutex> lk(wake_mtx);
+                wake_cv.wait_for(lk, std::chrono::milliseconds(100), [this] { return is_shutdown || has_next_command(); });
+            }
+        }
+
+        bool TrackerInterface::has_next_command()
+        {
+            FrameCommand *frame = frame_queue.front();
+            DetectionCommand *detection = detection_queue.front();
+            LidarCommand *lidar = lidar_queue.front();
+            return (frame && frame->seq == next_command_seq) || (detection && detection->seq == next_command_seq) ||
+                   (lidar && lidar->seq == next_command_seq);
+        }
+
+        bool TrackerInterface::apply_next_command()
+        {
+            //the queues are ordered by themselves, and every sequence number is pushed, so the next command is at one of their heads;
+            //if it is not there yet, its producer is still pushing it, and the later commands wait for it
+            FrameCommand *frame = frame_queue.front();
+            if (frame && frame->seq == next_command_seq)
+            {
+                std::vector<LocalObject> dead_object = update_bbox_by_tracker(frame->img, frame->update_time);
+                if (!dead_object.empty() && dead_object_callback)
+                {
+                    dead_object_callback(dead_object);
+                }
+                last_update_time = frame->update_time;
+                command_stats.frame_num++;
+                frame_queue.pop();
+                next_command_seq++;
+                return true;
+            }
+            DetectionCommand *detection = detection_queue.front();
+            if (detection && detection->seq == next_command_seq)
+            {
+                if (!detection->feature.empty())
+                {
+                    update_bbox_by_detector(detection->img, detection->bboxes, detection->feature, detection->update_time);
+                }
+                last_update_time = detection->update_time;
+                command_stats.detection_num++;
+                detection_queue.pop();
+                next_command_seq++;
+                return true;
+            }
+            LidarCommand *lidar = lidar_queue.front();
+            if (lidar && lidar->seq == next_command_seq)
+            {
+                update_position_by_lidar(lidar->msg_pc);
+                command_stats.lidar_num++;
+                lidar_queue.pop();
+                next_command_seq++;
+                return true;
+            }
+            return false;
+        }
+
+        void TrackerInterface::publish_snapshot()
+        {
+            std::shared_ptr<TrackerSnapshot> snapshot = std::make_shared<TrackerSnapshot>();
+            snapshot->stamp = last_update_time;
+            for (const auto &lo : local_objects_list)
+            {
+                snapshot->ids.push_back(lo.id);
+                snapshot->bboxes.push_back(lo.bbox);
+
+                TrackerHealth &health = snapshot->health;
+                health.min_ticks_to_timeout = std::min(health.min_ticks_to_timeout,
+                                                       std::min(track_fail_timeout_tick - lo.tracking_fail_count,
+                                                                detector_update_timeout_tick - lo.detector_update_count));
+                health.failing_num += lo.tracking_fail_count > 0;
+                health.overlap_num += lo.is_overlap;
+                health.min_keypoint_num = std::min(health.min_keypoint_num, static_cast<int>(lo.keypoints_curr.size()));
+            }
+            snapshot->health.track_num = local_objects_list.size();
+            snapshot->motion_ratio = motion_estimator.motion_ratio();
+            snapshot->crop_pool_stats = crop_pool.stats();
+            snapshot->command_stats = command_stats;
+            snapshot->command_stats.drop_num = command_drop_num;
+            snapshot->command_stats.pending_num = frame_queue.size() + detection_queue.size() + lidar_queue.size();
+            //only the tracker thread writes it, the readers keep the snapshot they loaded alive
+            std::atomic_store(&snapshot_, std::shared_ptr<const TrackerSnapshot>(snapshot));
         }
 
         std::vector<LocalObject> TrackerInterface::update_bbox_by_tracker(const cv::Mat &img, const ros::Time &update_time)
@@ -29,7 +207,8 @@ namespace ptl
             //update the tracker and the database of each tracking object
             timer efficiency_clock;
             track_bbox_by_optical_flow(img, update_time, true);
-            ROS_INFO_STREAM("update tracker:" << efficiency_clock.toc() * 1000 << " ms");
+            motion_estimator.update(opt_tracker.gray_frame());
+            ROS_INFO_STREAM("update tracker:" << efficiency_clock.toc() * 1000 << " ms, motion ratio: " << motion_estimator.motion_ratio());
 
             //remove the tracker that loses track and also check whether enable opt(to avoid degeneration under occlusion)
             efficiency_clock.tic();
@@ -58,7 +237,7 @@ namespace ptl
 
         void TrackerInterface::update_bbox_by_detector(const cv::Mat &img,
                                                        const std::vector<cv::Rect2d> &bboxes,
-                                                       const std::vector<float> features_detector,
+                                                       const std::vector<float> &features_detector,
                                                        const ros::Time &update_time)
         {
             ROS_INFO_STREAM("******Update Bbox by Detector******");
@@ -87,7 +266,14 @@ namespace ptl
             std::cout << std::endl;
         }
 
-        void TrackerInterface::lidar_tracker_callback(const sensor_msgs::PointCloud2ConstPtr &msg_pc)
+        void TrackerInterface::get_tracking_bboxes(std::vector<int> &ids, std::vector<cv::Rect2d> &bboxes) const
+        {
+            std::shared_ptr<const TrackerSnapshot> state = snapshot();
+            ids = state->ids;
+            bboxes = state->bboxes;
+        }
+
+        void TrackerInterface::update_position_by_lidar(const sensor_msgs::PointCloud2ConstPtr &msg_pc)
         {
             ROS_INFO_STREAM("******Into Localization Callback******");
             timer efficency_timer;
@@ -144,11 +330,15 @@ namespace ptl
             GPARAM(n, "/tracker/reid_match_threshold", reid_match_threshold);
             GPARAM(n, "/tracker/reid_match_bbox_dis", reid_match_bbox_dis);
             GPARAM(n, "/tracker/reid_match_bbox_size_diff", reid_match_bbox_size_diff);
+            GPARAM(n, "/tracker/command_queue_size", command_queue_size);
 
             GPARAM(n, "/local_database/height_width_ratio_min", height_width_ratio_min);
             GPARAM(n, "/local_database/height_width_ratio_max", height_width_ratio_max);
             GPARAM(n, "/local_database/record_interval", record_interval);
             GPARAM(n, "/local_database/feature_smooth_ratio", feature_smooth_ratio);
+            GPARAM(n, "/local_database/feature_reservoir_capacity", feature_reservoir_capacity);
+            GPARAM(n, "/local_database/crop_pool_slot_num", crop_pool_param.slot_num);
+            GPARAM(n, "/local_database/crop_pool_track_capacity", crop_pool_param.track_capacity);
 
             //point_cloud_processor
             GPARAM(n, "/pc_processor/resample_size", pcp_param.resample_size);
@@ -204,6 +394,10 @@ namespace ptl
             GPARAM(n, "/optical_flow/min_pixel_dis_square_for_scene_point", opt_param.min_pixel_dis_square_for_scene_point);
             GPARAM(n, "/optical_flow/use_resize", opt_param.use_resize);
             GPARAM(n, "/optical_flow/resize_factor", opt_param.resize_factor);
+
+            //motion estimator
+            GPARAM(n, "/motion_estimator/block_size", motion_param.block_size);
+            GPARAM(n, "/motion_estimator/block_diff_threshold", motion_param.block_diff_threshold);
         }
 
         bool TrackerInterface::update_local_database(LocalObject &local_object, const cv::Mat &img_block)
@@ -215,7 +409,26 @@ namespace ptl
                 1.0 * img_block.rows / img_block.cols < height_width_ratio_max &&
                 local_object.database_update_timer.toc() > record_interval)
             {
-                local_object.img_blocks.push_back(img_block);
+                //copy the block into the crop pool, instead of keeping a view of the whole frame
+                cv::Mat block;
+                int index = crop_pool.put(local_object.id, img_block, block);
+                if (index < 0)
+                {
+                    ROS_WARN_STREAM("The crop pool is full, drop an image of id: " << local_object.id);
+                    return false;
+                }
+                if (index == local_object.img_blocks.size())
+                {
+                    local_object.img_blocks.push_back(block);
+                    local_object.img_blocks_occluded.push_back(local_object.is_overlap);
+                    local_object.img_blocks_size.push_back(img_block.size());
+                }
+                else
+                {
+                    local_object.img_blocks[index] = block;
+                    local_object.img_blocks_occluded[index] = local_object.is_overlap;
+                    local_object.img_blocks_size[index] = img_block.size();
+                }
                 local_object.database_update_timer.tic();
                 ROS_INFO_STREAM("Adding an image to the datebase id: " << local_object.id);
                 return true;
@@ -356,7 +569,6 @@ namespace ptl
 
         void TrackerInterface::update_overlap_flag()
         {
-            // lock_guard<mutex> lk(mtx); //lock the thread
             for (auto &lo : local_objects_list)
             {
                 lo.is_overlap = false;
@@ -416,6 +628,13 @@ namespace ptl
                 // 2. continuous tracking failure in optical flow tracking
                 if (lo->tracking_fail_count >= track_fail_timeout_tick || lo->detector_update_count >= detector_update_timeout_tick)
                 {
+                    //the slots of the crop pool are reused once released, so the dead tracker takes its own copy
+                    for (auto &ib : lo->img_blocks)
+                    {
+                        ib = ib.clone();
+                    }
+                    crop_pool.release(lo->id);
+
                     ptl_msgs::DeadTracker msg_pub; // publish the dead tracker to reid
                     for (auto ib : lo->img_blocks)
                     {
@@ -423,7 +642,6 @@ namespace ptl
                     }
                     msg_pub.position = lo->position;
                     dead_tracking_object.push_back(*lo);
-                    lock_guard<mutex> lk(mtx); //lock the thread
                     lo = local_objects_list.erase(lo);
                     continue;
                 }
@@ -442,9 +660,12 @@ namespace ptl
 
         void TrackerInterface::report_local_object()
         {
-            // lock_guard<mutex> lk(mtx); //lock the thread
             ROS_INFO("------Local Object List Summary------");
             ROS_INFO_STREAM("Local Object Num: " << local_objects_list.size());
+            CropPoolStats pool_stats = crop_pool.stats();
+            ROS_INFO_STREAM("Crop pool: " << pool_stats.used_slot_num << "/" << pool_stats.slot_num << " slots, "
+                                          << pool_stats.bytes_used / (1 << 20) << "/" << pool_stats.bytes_reserved / (1 << 20) << " MB, "
+                                          << pool_stats.drop_num << " dropped");
             for (auto lo : local_objects_list)
             {
                 ROS_INFO_STREAM("id: " << lo.id << "| database images num: " << lo.img_blocks.size());
@@ -455,7 +676,6 @@ namespace ptl
 
         void TrackerInterface::visualize_tracking(cv::Mat &img)
         {
-            // lock_guard<mutex> lk(mtx); //lock the thread
             for (auto lo : local_objects_list)
             {
                 if (lo.is_opt_enable)
@@ -475,7 +695,6 @@ namespace ptl
                                                                 const std::vector<Eigen::VectorXf> &features,
                                                                 std::vector<AssociationVector> &all_detected_bbox_ass_vec)
         {
-            // lock_guard<mutex> lk(mtx); //lock
             if (!local_objects_list.empty())
             {
                 ROS_INFO_STREAM("SUMMARY:" << bboxes.size() << " bboxes detected!");
@@ -544,10 +763,11 @@ namespace ptl
                     cv::resize(img(bboxes[i]), example_img, cv::Size(128, 256)); //hard code in here
                     LocalObject new_object(local_id_not_assigned, bboxes[i], features[i],
                                            kf_param, kf3d_param, update_time, example_img);
+                    new_object.feature_reservoir = FeatureReservoir(feature_reservoir_capacity);
+                    new_object.feature_reservoir.add(features[i].data(), features[i].size());
                     local_id_not_assigned++;
                     //update database
                     update_local_database(new_object, img(new_object.bbox));
-                    lock_guard<mutex> lk(mtx); //lock the thread
                     local_objects_list.push_back(new_object);
                 }
                 else
@@ -557,7 +777,7 @@ namespace ptl
                     ROS_INFO_STREAM("Object " << local_objects_list[matched_id].id << " re-detected!");
 
                     local_objects_list[matched_id].track_bbox_by_detector(bboxes[i], update_time);
-                    local_objects_list[matched_id].features.push_back(features[i]);
+                    local_objects_list[matched_id].feature_reservoir.add(features[i].data(), features[i].size());
                     local_objects_list[matched_id].update_feat(features[i], feature_smooth_ratio);
 
                     //update database
@@ -588,10 +808,9 @@ namespace ptl
                     LocalObject new_object(local_id_not_assigned, bboxes[i], feat_eigen[i],
                                            kf_param, kf3d_param, update_time, example_img);
                     local_id_not_assigned++;
-                    lock_guard<mutex> lk(mtx); //lock the thread
-                    //insert the 2048d feature vector
-                    new_object.features_vector.insert(new_object.features_vector.end(), feat_vector.begin(), feat_vector.end());
-
+                    //insert the 2048d feature vector of this detection
+                    new_object.feature_reservoir = FeatureReservoir(feature_reservoir_capacity);
+                    new_object.feature_reservoir.add(feat_vector.data() + i * feat_dimension, feat_dimension);
                     local_objects_list.push_back(new_object);
                 }
                 else
@@ -603,9 +822,7 @@ namespace ptl
                     local_objects_list[matched_id].track_bbox_by_detector(bboxes[i], update_time);
                     local_objects_list[matched_id].update_feat(feat_eigen[i], feature_smooth_ratio);
                     //insert the 2048d feature vector
-                    local_objects_list[matched_id].features_vector.insert(local_objects_list[matched_id].features_vector.end(),
-                                                                          feat_vector.begin() + i * feat_dimension,
-                                                                          feat_vector.begin() + (i + 1) * feat_dimension);
+                    local_objects_list[matched_id].feature_reservoir.add(feat_vector.data() + i * feat_dimension, feat_dimension);
                 }
             }
 